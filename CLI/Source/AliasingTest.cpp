@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    AliasingTest.cpp
+
+  ==============================================================================
+*/
+
+#include "AliasingTest.h"
+
+AliasingTest::AliasingTest(const AliasingTestOptions& newOptions) : options(newOptions) {
+    bin = juce::roundToInt(options.frequency * fftSize / options.sampleRate) | 1;
+    bin = juce::jlimit(1, fftSize / 2 - 1, bin);
+
+    // One period of the FFT length, repeated as long as needed
+    auto amplitude = juce::Decibels::decibelsToGain(options.levelDecibels);
+    input.resize((size_t) fftSize);
+
+    for (size_t i = 0; i < input.size(); ++i)
+        input[i] = amplitude * (float) std::sin(juce::MathConstants<double>::twoPi * (double) bin * (double) i / fftSize);
+}
+
+void AliasingTest::run() {
+    static const juce::StringArray curveNames {"Hard", "Tanh", "Diode", "Asym", "Circuit"};
+    static const juce::StringArray antialiasingNames {"Off", "ADAA1", "ADAA2"};
+
+    std::cout << "DRIVE stage, " << juce::String(getTestFrequency(), 1) << " Hz at " << juce::String(options.levelDecibels, 1)
+              << " dBFS, " << juce::String(juce::roundToInt(options.sampleRate)) << " Hz" << std::endl << std::endl;
+
+    std::cout << juce::String("curve").paddedRight(' ', 9) << juce::String("method").paddedRight(' ', 10)
+              << juce::String("aliasing dB").paddedLeft(' ', 12) << juce::String("ns/sample").paddedLeft(' ', 11)
+              << juce::String("cost").paddedLeft(' ', 7) << std::endl;
+
+    for (auto curve : options.curves) {
+        juce::Array<AliasingResult> cases;
+
+        for (int antialiasing = 0; antialiasing <= (int) ShaperAntialiasing::SecondOrder; ++antialiasing)
+            cases.add(measure(curve, antialiasing, 0));
+
+        for (auto factorIndex : options.factorIndices)
+            cases.add(measure(curve, 0, factorIndex));
+
+        // Cost against plain clipping at the base rate
+        auto plain = cases.getFirst().nanosecondsPerSample;
+
+        for (auto& result : cases) {
+            auto method = result.oversampling > 0 ? juce::String(1 << result.oversampling) + "x IIR" : antialiasingNames[result.antialiasing];
+
+            std::cout << curveNames[curve].paddedRight(' ', 9) << method.paddedRight(' ', 10)
+                      << juce::String(result.aliasingDecibels, 1).paddedLeft(' ', 12)
+                      << juce::String(result.nanosecondsPerSample, 2).paddedLeft(' ', 11)
+                      << (juce::String(plain > 0.0 ? result.nanosecondsPerSample / plain : 0.0, 1) + "x").paddedLeft(' ', 7) << std::endl;
+
+            results.add(result);
+        }
+    }
+}
+
+AliasingResult AliasingTest::measure(int curve, int antialiasing, int oversampling) {
+    juce::ScopedNoDenormals noDenormals;
+
+    // Mono, set up the way RokmanEngine::prepare sets up its DRIVE stage
+    DriveSection drive;
+    drive.setNumActiveLanes(1);
+    drive.prepare({options.sampleRate, (juce::uint32) options.blockSize, 1});
+    drive.setOversampling(oversampling, DriveSection::Oversampler::filterHalfBandPolyphaseIIR);
+
+    drive.forEachProcessor([&](auto& shaper) {
+        shaper.setDrive(35.0f);
+        shaper.setCeiling(1.4f);
+        shaper.setCurve(static_cast<ShaperCurve>(curve));
+        shaper.setAntialiasing(static_cast<ShaperAntialiasing>(antialiasing));
+    });
+
+    drive.reset();
+
+    juce::HeapBlock<char> blockData;
+    juce::dsp::AudioBlock<SIMDFloat> block(blockData, 1, (size_t) options.blockSize);
+    block.clear();
+
+    auto* registers = block.getChannelPointer(0);
+    std::vector<float> output;
+    size_t position = 0;
+
+    auto processBlock = [&](bool keep) {
+        for (size_t i = 0; i < block.getNumSamples(); ++i) {
+            registers[i] = SIMDFloat::expand(0.0f);
+            registers[i].set(0, input[position]);
+            position = (position + 1) % input.size();
+        }
+
+        juce::dsp::ProcessContextReplacing<SIMDFloat> context(block);
+        drive.process(context);
+
+        if (keep)
+            for (size_t i = 0; i < block.getNumSamples(); ++i)
+                output.push_back(registers[i].get(0));
+    };
+
+    // The filters settle and the output becomes periodic, then one FFT
+    // length is kept and timed
+    auto numBlocks = (fftSize + options.blockSize - 1) / options.blockSize;
+
+    for (int i = 0; i < numBlocks; ++i)
+        processBlock(false);
+
+    output.reserve((size_t) (numBlocks * options.blockSize));
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (int i = 0; i < numBlocks; ++i)
+        processBlock(true);
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    std::vector<float> fftData((size_t) fftSize * 2, 0.0f);
+    std::copy(output.end() - fftSize, output.end(), fftData.begin());
+
+    juce::dsp::FFT fft(fftOrder);
+    fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+    double harmonics = 0.0, aliases = 0.0;
+
+    for (int k = 1; k < fftSize / 2; ++k) {
+        auto power = (double) fftData[(size_t) k] * (double) fftData[(size_t) k];
+
+        if (k % bin == 0)
+            harmonics += power;
+        else
+            aliases += power;
+    }
+
+    AliasingResult result;
+    result.curve = curve;
+    result.antialiasing = antialiasing;
+    result.oversampling = oversampling;
+    result.aliasingDecibels = 10.0 * std::log10(juce::jmax(aliases, 1.0e-30) / juce::jmax(harmonics, 1.0e-30));
+    result.nanosecondsPerSample = seconds * 1.0e9 / ((double) numBlocks * options.blockSize);
+    return result;
+}
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    AliasingTest.h
+
+    Measures how much the DRIVE stage aliases, and what it costs, with plain
+    clipping, ADAA and oversampling. A sine on an exact FFT bin goes through
+    the stage on its own, so every harmonic lands on a multiple of that bin
+    and whatever lands anywhere else has folded back. No window is needed:
+    the steady-state output repeats exactly over the FFT length.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/RokmanEngine.h"
+
+struct AliasingTestOptions {
+    double sampleRate {48000.0};
+
+    // Moved to the nearest odd bin, so no alias falls on a harmonic
+    double frequency {2500.0};
+
+    // Sine level before the stage's drive, dBFS
+    float levelDecibels {-20.0f};
+
+    juce::Array<int> curves {(int) ShaperCurve::HardClip, (int) ShaperCurve::Tanh};
+    juce::Array<int> factorIndices {1, 2, 3};
+
+    int blockSize {512};
+};
+
+struct AliasingResult {
+    int curve {0};
+    int antialiasing {0};
+    int oversampling {0};
+
+    // Folded power against the power at the harmonics, dB
+    double aliasingDecibels {0.0};
+    double nanosecondsPerSample {0.0};
+};
+
+class AliasingTest {
+public:
+    explicit AliasingTest(const AliasingTestOptions& options);
+
+    // Every ADAA order at 1x, then plain clipping at each oversampling
+    // factor, for each curve. Prints a table as it goes
+    void run();
+
+    const juce::Array<AliasingResult>& getResults() const { return results; }
+
+    double getTestFrequency() const { return bin * options.sampleRate / fftSize; }
+
+private:
+    using SIMDFloat = juce::dsp::SIMDRegister<float>;
+    using DriveSection = OversampledStage<SIMDFloat, ShaperStage>;
+
+    static constexpr int fftOrder = 16;
+    static constexpr int fftSize = 1 << fftOrder;
+
+    AliasingResult measure(int curve, int antialiasing, int oversampling);
+
+    AliasingTestOptions options;
+    int bin {1};
+    std::vector<float> input;
+    juce::Array<AliasingResult> results;
+};
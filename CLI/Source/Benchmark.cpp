@@ -0,0 +1,296 @@
+/*
+  ==============================================================================
+
+    Benchmark.cpp
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+
+juce::String BenchmarkResult::getKey() const {
+    return Benchmark::getModeName(mode) + "/" + stage + "/" + juce::String(blockSize) + "/" + juce::String(juce::roundToInt(sampleRate));
+}
+
+double BenchmarkResult::getInstancesPerCore() const {
+    return nanosecondsPerSample > 0.0 ? 1.0e9 / (nanosecondsPerSample * sampleRate) : 0.0;
+}
+
+//==============================================================================
+Benchmark::Benchmark(const BenchmarkOptions& newOptions) : options(newOptions) {
+    // -12 dBFS white noise, the same every run
+    juce::Random random(0x526f6b);
+    auto maximumBlockSize = 1;
+
+    for (auto blockSize : options.blockSizes)
+        maximumBlockSize = juce::jmax(maximumBlockSize, blockSize);
+
+    noise.setSize(juce::jmax(options.numChannels, options.numVoices), maximumBlockSize);
+
+    for (int channel = 0; channel < noise.getNumChannels(); ++channel)
+        for (int i = 0; i < noise.getNumSamples(); ++i)
+            noise.setSample(channel, i, 0.25f * (2.0f * random.nextFloat() - 1.0f));
+}
+
+juce::String Benchmark::getModeName(int mode) {
+    static const juce::StringArray names {"Dist", "Edge", "Cln1", "Cln2"};
+    return names[mode];
+}
+
+juce::String Benchmark::getStageName(int position) {
+    static const juce::StringArray names {"HPF", "Comp", "EQ1", "DRIVE", "EQ2", "DEL1"};
+    return names[position];
+}
+
+void Benchmark::run() {
+    juce::ScopedNoDenormals noDenormals;
+
+    for (auto mode : options.modes) {
+        for (auto sampleRate : options.sampleRates) {
+            std::cout << std::endl << getModeName(mode) << " @ " << juce::String(juce::roundToInt(sampleRate)) << " Hz, ns/sample" << std::endl;
+
+            auto header = juce::String("block").paddedLeft(' ', 6) + juce::String("total").paddedLeft(' ', 10)
+                        + juce::String("inst/core").paddedLeft(' ', 11) + juce::String("I/O").paddedLeft(' ', 8);
+
+            for (int position = 0; position < numStages; ++position)
+                header << getStageName(position).paddedLeft(' ', 8);
+
+            if (options.numVoices > 0)
+                header << juce::String("separate").paddedLeft(' ', 10) << juce::String("batch").paddedLeft(' ', 8);
+
+            std::cout << header << std::endl;
+
+            for (auto blockSize : options.blockSizes)
+                runCase(mode, sampleRate, blockSize);
+        }
+    }
+}
+
+template <typename Function>
+double Benchmark::measure(double sampleRate, int blockSize, Function&& processBlock) const {
+    auto numBlocks = juce::jmax(1, juce::roundToInt(options.secondsPerRun * sampleRate / blockSize));
+
+    // Settles the filters and warms the caches
+    for (int i = 0; i < juce::jmin(numBlocks, 64); ++i)
+        processBlock();
+
+    auto best = std::numeric_limits<double>::max();
+
+    for (int run = 0; run < juce::jmax(1, options.numRuns); ++run) {
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numBlocks; ++i)
+            processBlock();
+
+        best = juce::jmin(best, juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start));
+    }
+
+    return best * 1.0e9 / ((double) numBlocks * blockSize);
+}
+
+void Benchmark::fill(juce::AudioBuffer<float>& buffer) const {
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        buffer.copyFrom(channel, 0, noise, channel, 0, buffer.getNumSamples());
+}
+
+void Benchmark::add(int mode, double sampleRate, int blockSize, const juce::String& stage, double nanosecondsPerSample) {
+    BenchmarkResult result;
+    result.mode = mode;
+    result.sampleRate = sampleRate;
+    result.blockSize = blockSize;
+    result.stage = stage;
+    result.nanosecondsPerSample = nanosecondsPerSample;
+    results.add(result);
+}
+
+void Benchmark::runCase(int mode, double sampleRate, int blockSize) {
+    auto settings = options.settings;
+    settings.mode = mode;
+
+    // Set up the way RokmanAudioProcessor::prepareToPlay does it
+    ModeSwitcher switcher;
+    switcher.setSubBlockSize(options.subBlockSize);
+    switcher.prepare(sampleRate, blockSize, options.numChannels);
+    switcher.setChainSettings(settings);
+    switcher.reset();
+
+    // A bare engine for the stages one at a time
+    RokmanEngine engine;
+    engine.setSubBlockSize(options.subBlockSize);
+    engine.prepare(sampleRate, blockSize, options.numChannels);
+    engine.setChainSettings(settings);
+    engine.reset();
+
+    juce::AudioBuffer<float> buffer(options.numChannels, blockSize);
+
+    auto total = measure(sampleRate, blockSize, [&] { fill(buffer); switcher.process(buffer); });
+    add(mode, sampleRate, blockSize, "processBlock", total);
+    auto instancesPerCore = results.getLast().getInstancesPerCore();
+
+    auto io = measure(sampleRate, blockSize, [&] { fill(buffer); engine.processStage(-1, buffer); });
+    add(mode, sampleRate, blockSize, "I/O", io);
+
+    auto line = juce::String(blockSize).paddedLeft(' ', 6) + juce::String(total, 2).paddedLeft(' ', 10)
+              + juce::String(juce::roundToInt(instancesPerCore)).paddedLeft(' ', 11)
+              + juce::String(io, 2).paddedLeft(' ', 8);
+
+    // Stage times are net of the interleaving and the copy of the input
+    for (int position = 0; position < numStages; ++position) {
+        if (! RokmanEngine::isStageActive(mode, position)) {
+            line << juce::String("-").paddedLeft(' ', 8);
+            continue;
+        }
+
+        auto stage = juce::jmax(0.0, measure(sampleRate, blockSize, [&] { fill(buffer); engine.processStage(position, buffer); }) - io);
+        add(mode, sampleRate, blockSize, getStageName(position), stage);
+        line << juce::String(stage, 2).paddedLeft(' ', 8);
+    }
+
+    if (options.numVoices > 0) {
+        auto [separate, batch] = measureVoices(settings, sampleRate, blockSize);
+        add(mode, sampleRate, blockSize, "separate", separate);
+        add(mode, sampleRate, blockSize, "batch", batch);
+        line << juce::String(separate, 2).paddedLeft(' ', 10) << juce::String(batch, 2).paddedLeft(' ', 8);
+    }
+
+    std::cout << line << std::endl;
+}
+
+std::pair<double, double> Benchmark::measureVoices(const ChainSettings& settings, double sampleRate, int blockSize) {
+    juce::AudioBuffer<float> buffer(options.numVoices, blockSize);
+
+    // One mono engine per track, the way separate plugin instances run
+    std::vector<std::unique_ptr<RokmanEngine>> engines;
+
+    for (int voice = 0; voice < options.numVoices; ++voice) {
+        auto& engine = *engines.emplace_back(std::make_unique<RokmanEngine>());
+        engine.setSubBlockSize(options.subBlockSize);
+        engine.prepare(sampleRate, blockSize, 1);
+        engine.setChainSettings(settings);
+        engine.reset();
+    }
+
+    auto processSeparately = [&](juce::AudioBuffer<float>& tracks) {
+        for (int voice = 0; voice < options.numVoices; ++voice) {
+            juce::AudioBuffer<float> track(tracks.getArrayOfWritePointers() + voice, 1, blockSize);
+            engines[(size_t) voice]->process(track);
+        }
+    };
+
+    juce::Array<ChainSettings> voiceSettings;
+    voiceSettings.insertMultiple(0, settings, options.numVoices);
+
+    BatchEngine batch;
+    batch.setSubBlockSize(options.subBlockSize);
+    batch.prepare(sampleRate, blockSize, voiceSettings);
+
+    // 250 ms from reset through both, long enough for the chorus and the
+    // compressor to have moved. Every track has to come out the same
+    {
+        juce::AudioBuffer<float> expected(options.numVoices, blockSize);
+        auto numBlocks = juce::jmax(1, juce::roundToInt(0.25 * sampleRate / blockSize));
+        auto maxDifference = 0.0f;
+        auto worstVoice = -1;
+
+        for (int block = 0; block < numBlocks; ++block) {
+            fill(expected);
+            processSeparately(expected);
+
+            fill(buffer);
+            batch.process(buffer);
+
+            for (int voice = 0; voice < options.numVoices; ++voice) {
+                for (int i = 0; i < blockSize; ++i) {
+                    auto difference = std::abs(buffer.getSample(voice, i) - expected.getSample(voice, i));
+
+                    if (difference > maxDifference) {
+                        maxDifference = difference;
+                        worstVoice = voice;
+                    }
+                }
+            }
+        }
+
+        if (worstVoice >= 0)
+            voiceMismatches.add(getModeName(settings.mode) + "/" + juce::String(blockSize) + "/" + juce::String(juce::roundToInt(sampleRate))
+                                + ": voice " + juce::String(worstVoice) + " is up to "
+                                + juce::String(juce::Decibels::gainToDecibels(maxDifference), 1) + " dBFS off its own engine");
+    }
+
+    auto separate = measure(sampleRate, blockSize, [&] { fill(buffer); processSeparately(buffer); });
+    auto batched = measure(sampleRate, blockSize, [&] { fill(buffer); batch.process(buffer); });
+
+    // Per track
+    return {separate / options.numVoices, batched / options.numVoices};
+}
+
+//==============================================================================
+juce::var Benchmark::toJSON() const {
+    auto* settings = new juce::DynamicObject();
+    settings->setProperty("oversampling", options.settings.oversampling);
+    settings->setProperty("oversamplingFilter", options.settings.oversamplingFilter);
+    settings->setProperty("clipper", options.settings.clipper);
+    settings->setProperty("antialiasing", options.settings.antialiasing);
+    settings->setProperty("chorus", options.settings.chorus);
+    settings->setProperty("echo", options.settings.echo);
+    settings->setProperty("numChannels", options.numChannels);
+    settings->setProperty("numVoices", options.numVoices);
+    settings->setProperty("subBlockSize", options.subBlockSize);
+
+    juce::Array<juce::var> cases;
+
+    for (auto& result : results) {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("key", result.getKey());
+        object->setProperty("nsPerSample", result.nanosecondsPerSample);
+        cases.add(juce::var(object));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("settings", juce::var(settings));
+    root->setProperty("results", cases);
+
+    return juce::var(root);
+}
+
+bool Benchmark::hasSameSettings(const juce::var& baseline) const {
+    auto settings = baseline["settings"];
+
+    return (int) settings["oversampling"] == options.settings.oversampling
+        && (int) settings["oversamplingFilter"] == options.settings.oversamplingFilter
+        && (int) settings["clipper"] == options.settings.clipper
+        && (int) settings["antialiasing"] == options.settings.antialiasing
+        && (bool) settings["chorus"] == options.settings.chorus
+        && (bool) settings["echo"] == options.settings.echo
+        && (int) settings["numChannels"] == options.numChannels
+        && (int) settings["numVoices"] == options.numVoices
+        && (int) settings.getProperty("subBlockSize", options.subBlockSize) == options.subBlockSize;
+}
+
+juce::StringArray Benchmark::findRegressions(const juce::var& baseline, double threshold, int& numCompared) const {
+    juce::StringArray regressions;
+    numCompared = 0;
+
+    std::map<juce::String, double> baselineTimes;
+
+    if (auto* cases = baseline["results"].getArray())
+        for (auto& entry : *cases)
+            baselineTimes[entry["key"].toString()] = (double) entry["nsPerSample"];
+
+    for (auto& result : results) {
+        auto found = baselineTimes.find(result.getKey());
+
+        // Tiny stages are all noise, anything under a nanosecond is left out
+        if (found == baselineTimes.end() || found->second < 1.0)
+            continue;
+
+        ++numCompared;
+        auto change = result.nanosecondsPerSample / found->second - 1.0;
+
+        if (change > threshold)
+            regressions.add(result.getKey() + ": " + juce::String(found->second, 2) + " -> " + juce::String(result.nanosecondsPerSample, 2)
+                            + " ns/sample (+" + juce::String(change * 100.0, 1) + "%)");
+    }
+
+    return regressions;
+}
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    Benchmark.h
+
+    Times the whole engine (what processBlock runs) and every stage on each
+    mode's path, for every mode, block size and sample rate asked for. The
+    results can be saved as JSON and compared against a saved baseline.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/BatchEngine.h"
+#include "../../Source/ModeSwitcher.h"
+
+struct BenchmarkOptions {
+    // Oversampling, clipper, antialiasing, chorus and echo, the mode comes
+    // from modes below
+    ChainSettings settings;
+
+    juce::Array<int> modes {CoefficientBank::Dist, CoefficientBank::Edge, CoefficientBank::Cln1, CoefficientBank::Cln2};
+    juce::Array<int> blockSizes {16, 32, 64, 128, 256, 512, 1024, 2048, 4096};
+    juce::Array<double> sampleRates {44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0};
+
+    int numChannels {2};
+
+    // How the engine splits each block, see RokmanEngine::setSubBlockSize
+    int subBlockSize {RokmanEngine::defaultSubBlockSize};
+
+    // Also times this many mono tracks, as separate engines and as one
+    // BatchEngine, and checks that every track comes out of the batch as it
+    // does out of its own engine. 0 leaves it out
+    int numVoices {0};
+
+    // Audio timed per measurement, the best of numRuns is kept
+    double secondsPerRun {0.25};
+    int numRuns {3};
+};
+
+struct BenchmarkResult {
+    int mode {0};
+    double sampleRate {0.0};
+    int blockSize {0};
+
+    // "processBlock", "I/O" for the interleaving alone, a ChainPositions name,
+    // or "separate" and "batch" for one of numVoices tracks
+    juce::String stage;
+    double nanosecondsPerSample {0.0};
+
+    juce::String getKey() const;
+    double getInstancesPerCore() const;
+};
+
+class Benchmark {
+public:
+    explicit Benchmark(const BenchmarkOptions& options);
+
+    // Runs every case and prints a table as it goes
+    void run();
+
+    const juce::Array<BenchmarkResult>& getResults() const { return results; }
+
+    // Cases where a batched track wasn't bit-identical to the same track
+    // through its own engine, as printable lines
+    const juce::StringArray& getVoiceMismatches() const { return voiceMismatches; }
+
+    juce::var toJSON() const;
+
+    // False if the baseline was run with other oversampling, clipper,
+    // antialiasing, chorus, echo, channel, voice or sub-block settings, its
+    // numbers can't be compared then. Baselines from before sub-blocks
+    // compare with any size
+    bool hasSameSettings(const juce::var& baseline) const;
+
+    // Every case that is more than threshold (0.1 = 10%) slower than in the
+    // baseline, as a printable line. Cases missing on either side are skipped
+    juce::StringArray findRegressions(const juce::var& baseline, double threshold, int& numCompared) const;
+
+    static juce::String getModeName(int mode);
+    static juce::String getStageName(int position);
+    static constexpr int numStages = RokmanEngine::numChainPositions;
+
+private:
+    BenchmarkOptions options;
+    juce::Array<BenchmarkResult> results;
+    juce::StringArray voiceMismatches;
+    juce::AudioBuffer<float> noise;
+
+    void runCase(int mode, double sampleRate, int blockSize);
+
+    template <typename Function>
+    double measure(double sampleRate, int blockSize, Function&& processBlock) const;
+
+    // ns per sample and track for numVoices tracks, separate and batched.
+    // Compares the two before timing them
+    std::pair<double, double> measureVoices(const ChainSettings& settings, double sampleRate, int blockSize);
+
+    void fill(juce::AudioBuffer<float>& buffer) const;
+    void add(int mode, double sampleRate, int blockSize, const juce::String& stage, double nanosecondsPerSample);
+};
@@ -0,0 +1,444 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    RokmanCLI, offline batch processing through the Rokman engine.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "AliasingTest.h"
+#include "Benchmark.h"
+#include "NullTest.h"
+#include "ReampJob.h"
+
+namespace {
+
+// Index of value in names, case insensitive. Empty gives the default
+int parseChoice(const juce::String& option, const juce::String& value, const juce::StringArray& names) {
+    if (value.isEmpty())
+        return 0;
+
+    for (int i = 0; i < names.size(); ++i)
+        if (names[i].equalsIgnoreCase(value))
+            return i;
+
+    juce::ConsoleApplication::fail(option + " must be one of " + names.joinIntoString(", "));
+    return 0;
+}
+
+int parseInteger(const juce::String& option, const juce::String& value, int defaultValue, int minimum, int maximum) {
+    if (value.isEmpty())
+        return defaultValue;
+
+    if (! value.containsOnly("0123456789") || ! juce::isPositiveAndNotGreaterThan(value.getIntValue() - minimum, maximum - minimum))
+        juce::ConsoleApplication::fail(option + " must be between " + juce::String(minimum) + " and " + juce::String(maximum));
+
+    return value.getIntValue();
+}
+
+float parseDecimal(const juce::String& option, const juce::String& value, float defaultValue, float minimum, float maximum) {
+    if (value.isEmpty())
+        return defaultValue;
+
+    if (! value.containsOnly("0123456789.-+") || value.getFloatValue() < minimum || value.getFloatValue() > maximum)
+        juce::ConsoleApplication::fail(option + " must be between " + juce::String(minimum) + " and " + juce::String(maximum));
+
+    return value.getFloatValue();
+}
+
+// Comma separated list, each item checked by parseItem. Empty keeps the default
+template <typename Type, typename ParseItem>
+juce::Array<Type> parseList(const juce::String& value, const juce::Array<Type>& defaultValues, ParseItem&& parseItem) {
+    if (value.isEmpty())
+        return defaultValues;
+
+    juce::Array<Type> values;
+
+    for (auto& item : juce::StringArray::fromTokens(value, ",", {}))
+        values.add(parseItem(item.trim()));
+
+    return values;
+}
+
+juce::File resolveFile(const juce::String& path) {
+    return juce::File::getCurrentWorkingDirectory().getChildFile(path.unquoted());
+}
+
+// Whatever is left once the options are removed, command aside
+juce::Array<juce::File> findInputFiles(const juce::ArgumentList& args, const juce::String& command) {
+    juce::Array<juce::File> files;
+
+    for (auto& argument : args.arguments) {
+        if (argument.isOption() || argument == command)
+            continue;
+
+        auto file = argument.resolveAsFile();
+
+        if (file.isDirectory())
+            files.addArray(file.findChildFiles(juce::File::findFiles, false, "*.wav;*.aif;*.aiff"));
+        else if (file.existsAsFile())
+            files.add(file);
+        else
+            juce::ConsoleApplication::fail("No such file: " + argument.text);
+    }
+
+    return files;
+}
+
+void printResult(const ReampResult& result) {
+    if (! result.wasOk()) {
+        std::cout << result.input.getFileName() << ": " << result.error << std::endl;
+        return;
+    }
+
+    std::cout << result.input.getFileName() << " -> " << result.output.getFullPathName()
+              << "  " << juce::String(result.getAudioSeconds(), 2) << " s in " << juce::String(result.seconds, 2) << " s"
+              << ", " << juce::String(result.getRealtimeFactor(), 1) << "x realtime"
+              << ", " << juce::String(result.getSamplesPerSecond() / 1.0e6, 2) << " M samples/s";
+
+    if (result.numChunks > 1)
+        std::cout << ", " << result.numChunks << " chunks";
+
+    if (result.chunkError >= 0.0)
+        std::cout << ", " << juce::Decibels::toString(juce::Decibels::gainToDecibels(result.chunkError, -200.0), 1, -200.0)
+                  << " max difference to serial";
+
+    std::cout << std::endl;
+}
+
+void reamp(const juce::ArgumentList& args) {
+    auto arguments = args;
+
+    ReampOptions options;
+    options.settings.mode = parseChoice("--mode", arguments.removeValueForOption("--mode|-m"), {"Dist", "Edge", "Cln1", "Cln2"});
+    options.settings.clipper = parseChoice("--clipper", arguments.removeValueForOption("--clipper"), {"Hard", "Tanh", "Diode", "Asym", "Circuit"});
+    options.settings.antialiasing = parseChoice("--adaa", arguments.removeValueForOption("--adaa"), {"Off", "ADAA1", "ADAA2"});
+    options.settings.oversampling = parseChoice("--oversampling", arguments.removeValueForOption("--oversampling"), {"1x", "2x", "4x", "8x"});
+    options.settings.oversamplingFilter = parseChoice("--filter", arguments.removeValueForOption("--filter"), {"IIR", "FIR"});
+    options.settings.chorus = arguments.removeOptionIfFound("--chorus");
+    options.settings.echo = arguments.removeOptionIfFound("--echo");
+    options.settings.drive = parseDecimal("--drive", arguments.removeValueForOption("--drive"), 0.0f, -12.0f, 12.0f);
+    options.settings.output = parseDecimal("--output-level", arguments.removeValueForOption("--output-level"), 0.0f, -24.0f, 12.0f);
+    options.settings.hpf = parseDecimal("--hpf", arguments.removeValueForOption("--hpf"), 0.0f, -1.0f, 1.0f);
+    options.settings.tone = parseDecimal("--tone", arguments.removeValueForOption("--tone"), 0.0f, -1.0f, 1.0f);
+    options.blockSize = parseInteger("--block", arguments.removeValueForOption("--block"), options.blockSize, 16, 65536);
+    options.chunkSeconds = parseDecimal("--chunk", arguments.removeValueForOption("--chunk"), 0.0f, 0.0f, 3600.0f);
+    options.preRollSeconds = parseDecimal("--pre-roll", arguments.removeValueForOption("--pre-roll"), (float) options.preRollSeconds, 0.0f, 60.0f);
+    options.verifyChunks = arguments.removeOptionIfFound("--verify");
+
+    auto numThreads = parseInteger("--threads", arguments.removeValueForOption("--threads|-j"), juce::SystemStats::getNumCpus(), 1, 256);
+
+    if (arguments.containsOption("--suffix"))
+        options.suffix = arguments.removeValueForOption("--suffix");
+
+    auto outputFolder = arguments.removeValueForOption("--output|-o");
+
+    if (outputFolder.isNotEmpty()) {
+        options.outputFolder = resolveFile(outputFolder);
+
+        if (! options.outputFolder.createDirectory())
+            juce::ConsoleApplication::fail("Can't create " + options.outputFolder.getFullPathName());
+    }
+
+    auto files = findInputFiles(arguments, "reamp");
+
+    if (files.isEmpty())
+        juce::ConsoleApplication::fail("No input files");
+
+    // Chunked, the files go one after another and each is spread over the
+    // pool. Otherwise every file is a job of its own
+    auto chunked = options.chunkSeconds > 0.0;
+
+    juce::ThreadPool pool(chunked ? numThreads : juce::jmin(numThreads, files.size()));
+    juce::OwnedArray<ReampJob> jobs;
+
+    for (auto& file : files)
+        jobs.add(new ReampJob(file, options, chunked ? &pool : nullptr));
+
+    auto start = juce::Time::getMillisecondCounterHiRes();
+
+    if (! chunked)
+        for (auto* job : jobs)
+            pool.addJob(job, false);
+
+    // Results come out in the order the files were given
+    juce::int64 totalSamples = 0;
+    double totalAudioSeconds = 0.0;
+    int numFailed = 0;
+
+    for (auto* job : jobs) {
+        if (chunked)
+            job->runJob();
+        else
+            pool.waitForJobToFinish(job, -1);
+
+        auto& result = job->getResult();
+        printResult(result);
+
+        if (result.wasOk()) {
+            totalSamples += result.numSamples;
+            totalAudioSeconds += result.getAudioSeconds();
+        } else {
+            ++numFailed;
+        }
+    }
+
+    auto seconds = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+    std::cout << std::endl << jobs.size() - numFailed << " of " << jobs.size() << " files, "
+              << juce::String(totalAudioSeconds, 2) << " s of audio in " << juce::String(seconds, 2) << " s on "
+              << pool.getNumThreads() << " threads, " << juce::String(seconds > 0.0 ? totalAudioSeconds / seconds : 0.0, 1) << "x realtime, "
+              << juce::String(seconds > 0.0 ? (double) totalSamples / seconds / 1.0e6 : 0.0, 2) << " M samples/s" << std::endl;
+
+    if (numFailed > 0)
+        juce::ConsoleApplication::fail(juce::String(numFailed) + " files failed");
+}
+
+void bench(const juce::ArgumentList& args) {
+    auto arguments = args;
+    BenchmarkOptions options;
+
+    options.settings.clipper = parseChoice("--clipper", arguments.removeValueForOption("--clipper"), {"Hard", "Tanh", "Diode", "Asym", "Circuit"});
+    options.settings.antialiasing = parseChoice("--adaa", arguments.removeValueForOption("--adaa"), {"Off", "ADAA1", "ADAA2"});
+    options.settings.oversampling = parseChoice("--oversampling", arguments.removeValueForOption("--oversampling"), {"1x", "2x", "4x", "8x"});
+    options.settings.oversamplingFilter = parseChoice("--filter", arguments.removeValueForOption("--filter"), {"IIR", "FIR"});
+    options.settings.chorus = arguments.removeOptionIfFound("--chorus");
+    options.settings.echo = arguments.removeOptionIfFound("--echo");
+
+    options.modes = parseList(arguments.removeValueForOption("--modes"), options.modes, [](const juce::String& item) {
+        return parseChoice("--modes", item, {"Dist", "Edge", "Cln1", "Cln2"});
+    });
+    options.blockSizes = parseList(arguments.removeValueForOption("--blocks"), options.blockSizes, [](const juce::String& item) {
+        return parseInteger("--blocks", item, 0, 1, 65536);
+    });
+    options.sampleRates = parseList(arguments.removeValueForOption("--rates"), options.sampleRates, [](const juce::String& item) {
+        return (double) parseInteger("--rates", item, 0, 8000, 768000);
+    });
+
+    options.numChannels = parseInteger("--channels", arguments.removeValueForOption("--channels"), options.numChannels, 1, RokmanEngine::getMaximumNumChannels());
+    options.subBlockSize = parseInteger("--sub-block", arguments.removeValueForOption("--sub-block"), options.subBlockSize,
+                                        RokmanEngine::minimumSubBlockSize, RokmanEngine::maximumSubBlockSize);
+    options.numVoices = parseInteger("--voices", arguments.removeValueForOption("--voices"), options.numVoices, 0, 1024);
+    options.numRuns = parseInteger("--runs", arguments.removeValueForOption("--runs"), options.numRuns, 1, 100);
+    options.secondsPerRun = parseInteger("--milliseconds", arguments.removeValueForOption("--milliseconds"),
+                                         juce::roundToInt(options.secondsPerRun * 1000.0), 1, 60000) / 1000.0;
+
+    auto threshold = parseInteger("--threshold", arguments.removeValueForOption("--threshold"), 10, 0, 1000) / 100.0;
+    auto savePath = arguments.removeValueForOption("--save");
+    auto baselinePath = arguments.removeValueForOption("--baseline");
+
+    // Read before running, a bad path shouldn't cost a whole run
+    juce::var baseline;
+
+    if (baselinePath.isNotEmpty()) {
+        baseline = juce::JSON::parse(resolveFile(baselinePath));
+
+        if (! baseline.isObject())
+            juce::ConsoleApplication::fail("Can't read the baseline " + baselinePath);
+    }
+
+    Benchmark benchmark(options);
+
+    if (baseline.isObject() && ! benchmark.hasSameSettings(baseline))
+        juce::ConsoleApplication::fail("The baseline was run with other --clipper, --adaa, --oversampling, --filter, --chorus, --echo, --channels, --voices or --sub-block settings");
+
+    benchmark.run();
+
+    if (savePath.isNotEmpty()) {
+        auto file = resolveFile(savePath);
+
+        if (! file.replaceWithText(juce::JSON::toString(benchmark.toJSON())))
+            juce::ConsoleApplication::fail("Can't write " + file.getFullPathName());
+
+        std::cout << std::endl << "Saved " << file.getFullPathName() << std::endl;
+    }
+
+    if (baseline.isObject()) {
+        int numCompared = 0;
+        auto regressions = benchmark.findRegressions(baseline, threshold, numCompared);
+
+        std::cout << std::endl << "Compared " << numCompared << " cases against " << baselinePath << std::endl;
+
+        for (auto& regression : regressions)
+            std::cout << "  " << regression << std::endl;
+
+        if (! regressions.isEmpty())
+            juce::ConsoleApplication::fail(juce::String(regressions.size()) + " cases are more than "
+                                           + juce::String(juce::roundToInt(threshold * 100.0)) + "% slower than the baseline");
+    }
+
+    auto& mismatches = benchmark.getVoiceMismatches();
+
+    if (! mismatches.isEmpty()) {
+        std::cout << std::endl;
+
+        for (auto& mismatch : mismatches)
+            std::cout << "  " << mismatch << std::endl;
+
+        juce::ConsoleApplication::fail(juce::String(mismatches.size()) + " cases where a batched track doesn't match its own engine");
+    }
+}
+
+void aliasing(const juce::ArgumentList& args) {
+    auto arguments = args;
+    AliasingTestOptions options;
+
+    options.sampleRate = parseInteger("--rate", arguments.removeValueForOption("--rate"), juce::roundToInt(options.sampleRate), 8000, 768000);
+    options.frequency = parseDecimal("--frequency", arguments.removeValueForOption("--frequency"), (float) options.frequency, 20.0f,
+                                     (float) options.sampleRate * 0.25f);
+    options.levelDecibels = parseDecimal("--level", arguments.removeValueForOption("--level"), options.levelDecibels, -60.0f, 0.0f);
+    options.blockSize = parseInteger("--block", arguments.removeValueForOption("--block"), options.blockSize, 16, 65536);
+
+    options.curves = parseList(arguments.removeValueForOption("--clippers"), options.curves, [](const juce::String& item) {
+        return parseChoice("--clippers", item, {"Hard", "Tanh", "Diode", "Asym", "Circuit"});
+    });
+
+    AliasingTest(options).run();
+}
+
+void nulltest(const juce::ArgumentList& args) {
+    auto arguments = args;
+    NullTestOptions options;
+
+    options.settings.clipper = parseChoice("--clipper", arguments.removeValueForOption("--clipper"), {"Hard", "Tanh", "Diode", "Asym", "Circuit"});
+    options.settings.antialiasing = parseChoice("--adaa", arguments.removeValueForOption("--adaa"), {"Off", "ADAA1", "ADAA2"});
+    options.settings.oversampling = parseChoice("--oversampling", arguments.removeValueForOption("--oversampling"), {"1x", "2x", "4x", "8x"});
+    options.settings.oversamplingFilter = parseChoice("--filter", arguments.removeValueForOption("--filter"), {"IIR", "FIR"});
+
+    options.modes = parseList(arguments.removeValueForOption("--modes"), options.modes, [](const juce::String& item) {
+        return parseChoice("--modes", item, {"Dist", "Edge", "Cln1", "Cln2"});
+    });
+    options.blockSizes = parseList(arguments.removeValueForOption("--blocks"), options.blockSizes, [](const juce::String& item) {
+        return parseInteger("--blocks", item, 0, 1, 65536);
+    });
+    options.sampleRates = parseList(arguments.removeValueForOption("--rates"), options.sampleRates, [](const juce::String& item) {
+        return (double) parseInteger("--rates", item, 0, 8000, 768000);
+    });
+
+    // Either replaces the error budget
+    auto& tolerance = options.tolerance;
+    tolerance.maxErrorDecibels = parseDecimal("--max-error", arguments.removeValueForOption("--max-error"), (float) tolerance.maxErrorDecibels, -200.0f, 0.0f);
+    tolerance.spectralDecibels = parseDecimal("--spectral", arguments.removeValueForOption("--spectral"), (float) tolerance.spectralDecibels, 0.0f, 60.0f);
+
+    auto savePath = arguments.removeValueForOption("--save");
+    options.recordings = findInputFiles(arguments, "nulltest");
+
+    NullTest test(options);
+    test.run();
+
+    if (savePath.isNotEmpty()) {
+        auto file = resolveFile(savePath);
+
+        if (! file.replaceWithText(juce::JSON::toString(test.toJSON())))
+            juce::ConsoleApplication::fail("Can't write " + file.getFullPathName());
+
+        std::cout << std::endl << "Saved " << file.getFullPathName() << std::endl;
+    }
+
+    if (test.getNumFailed() > 0)
+        juce::ConsoleApplication::fail(juce::String(test.getNumFailed()) + " of "
+                                       + juce::String(test.getResults().size() + test.getEchoDecayResults().size())
+                                       + " cases are further from the reference than the tolerance, or didn't decay");
+}
+
+} // namespace
+
+//==============================================================================
+int main(int argc, char* argv[]) {
+    juce::ConsoleApplication app;
+
+    app.addHelpCommand("--help|-h", "Usage: RokmanCLI [reamp] [options] <files or folders...>", false);
+    app.addVersionCommand("--version", "RokmanCLI " + juce::String(ProjectInfo::versionString));
+
+    app.addDefaultCommand({"reamp",
+                           "reamp [options] <files or folders...>",
+                           "Runs WAV/AIFF files through Rokman, one file per thread or in parallel chunks",
+                           "Options:\n"
+                           "  -m, --mode <Dist|Edge|Cln1|Cln2>      default Dist\n"
+                           "  --clipper <Hard|Tanh|Diode|Asym|Circuit>\n"
+                           "                                        AD 16 curve, default Hard\n"
+                           "  --adaa <Off|ADAA1|ADAA2>              antialiasing of the Hard and Tanh\n"
+                           "                                        curves, default Off\n"
+                           "  --oversampling <1x|2x|4x|8x>          default 1x\n"
+                           "  --filter <IIR|FIR>                    oversampling filter, default IIR\n"
+                           "  --chorus, --echo                      switch on DELAY 1's chorus and echo\n"
+                           "  --drive <dB>                          -12 to 12, default 0\n"
+                           "  --output-level <dB>                   -24 to 12, default 0\n"
+                           "  --hpf, --tone <octaves>               -1 to 1, default 0\n"
+                           "  -o, --output <folder>                 default: next to each input\n"
+                           "  --suffix <text>                       added to output names, default _rokman\n"
+                           "  -j, --threads <n>                     default: one per core\n"
+                           "  --block <samples>                     block size, default 4096\n"
+                           "  --chunk <seconds>                     splits each file into chunks rendered\n"
+                           "                                        in parallel, default 0 (off)\n"
+                           "  --pre-roll <seconds>                  settling time before each chunk, the\n"
+                           "                                        echo's decay is added, default 1\n"
+                           "  --verify                              also renders chunked files serially\n"
+                           "                                        and prints the largest difference",
+                           reamp});
+
+    app.addCommand({"bench",
+                    "bench [options]",
+                    "Times the engine and each stage for every mode, block size and sample rate",
+                    "Reports ns per sample and how many realtime instances fit on one core.\n\n"
+                    "Options:\n"
+                    "  --modes <Dist,Edge,Cln1,Cln2>         default all\n"
+                    "  --blocks <16,32,...>                  default 16 to 4096\n"
+                    "  --rates <44100,48000,...>             default 44100 to 192000\n"
+                    "  --channels <n>                        default 2\n"
+                    "  --sub-block <samples>                 the engine's internal block, 16 to\n"
+                    "                                        1024, default 64\n"
+                    "  --voices <n>                          also times n mono tracks, as separate\n"
+                    "                                        engines and as one batch, per track,\n"
+                    "                                        and fails if the two don't match\n"
+                    "  --clipper, --adaa, --oversampling,\n"
+                    "  --filter, --chorus, --echo            as for reamp\n"
+                    "  --milliseconds <ms>                   audio timed per run, default 250\n"
+                    "  --runs <n>                            the fastest run counts, default 3\n"
+                    "  --save <file.json>                    writes the results as a baseline\n"
+                    "  --baseline <file.json>                compares against a saved baseline and\n"
+                    "                                        fails if any case got slower than\n"
+                    "  --threshold <percent>                 default 10",
+                    bench});
+
+    app.addCommand({"aliasing",
+                    "aliasing [options]",
+                    "Measures the aliasing and the cost of the DRIVE stage with ADAA and with oversampling",
+                    "A sine goes through the stage alone, the folded power is reported against\n"
+                    "the power of the harmonics, the cost against plain clipping at the base rate.\n\n"
+                    "Options:\n"
+                    "  --rate <Hz>                           default 48000\n"
+                    "  --frequency <Hz>                      test tone, default 2500\n"
+                    "  --level <dBFS>                        before the stage's drive, default -20\n"
+                    "  --clippers <Hard,Tanh,...>            default Hard,Tanh\n"
+                    "  --block <samples>                     default 512",
+                    aliasing});
+
+    app.addCommand({"nulltest",
+                    "nulltest [options] [DI files or folders...]",
+                    "Checks the engine against the original ProcessorChain, frozen as ReferenceChain",
+                    "Sweep, impulse, plucked strings, silence, DC and denormal noise, plus any\n"
+                    "files given, go through both for every mode, rate and block size. Prints the\n"
+                    "largest sample difference, the residual, the largest third octave difference\n"
+                    "and the time per sample of both, and fails if the error budget is exceeded.\n"
+                    "The reference is rendered in double, the speed is against it in float.\n"
+                    "At every rate it also checks that a burst through the echo dies away.\n\n"
+                    "Options:\n"
+                    "  --modes <Dist,Edge,Cln1,Cln2>         default all\n"
+                    "  --blocks <16,128,...>                 default 16,128,1000,4096\n"
+                    "  --rates <44100,48000,...>             default 44100,48000,96000\n"
+                    "  --clipper, --adaa, --oversampling,\n"
+                    "  --filter                              as for reamp, the reference stays at\n"
+                    "                                        the hard clip and 1x\n"
+                    "  --max-error <dBFS>                    limit for every mode and rate, default\n"
+                    "                                        -92.5, what float rounding can add up to\n"
+                    "  --spectral <dB>                       limit for every mode and rate, default\n"
+                    "                                        0.08, what that error does to a band\n"
+                    "  --save <file.json>                    writes every case with its numbers",
+                    nulltest});
+
+    return app.findAndRunCommand(argc, argv);
+}
@@ -0,0 +1,456 @@
+/*
+  ==============================================================================
+
+    NullTest.cpp
+
+  ==============================================================================
+*/
+
+#include "NullTest.h"
+
+namespace {
+
+const juce::StringArray modeNames {"Dist", "Edge", "Cln1", "Cln2"};
+
+size_t getNumSamples(double seconds, double sampleRate) {
+    return (size_t) std::ceil(seconds * sampleRate);
+}
+
+} // namespace
+
+juce::String NullTestResult::getKey() const {
+    return modeNames[mode] + "/" + signal + "/" + juce::String(blockSize) + "/" + juce::String(juce::roundToInt(sampleRate));
+}
+
+//==============================================================================
+NullTest::NullTest(const NullTestOptions& newOptions) : options(newOptions) {
+    recordings = loadRecordings(options.recordings);
+}
+
+std::vector<NullTest::TestSignal> NullTest::loadRecordings(const juce::Array<juce::File>& files) {
+    std::vector<TestSignal> signals;
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    for (auto& file : files) {
+        std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+
+        if (reader == nullptr)
+            juce::ConsoleApplication::fail("Can't read " + file.getFullPathName());
+
+        // 30 s is plenty to hear a difference, and keeps every case short
+        auto numSamples = (int) juce::jmin(reader->lengthInSamples, (juce::int64) (reader->sampleRate * 30.0));
+
+        juce::AudioBuffer<float> buffer(1, numSamples);
+        reader->read(&buffer, 0, numSamples, 0, true, false);
+
+        auto* samples = buffer.getReadPointer(0);
+        signals.push_back({file.getFileNameWithoutExtension(), std::vector<float>(samples, samples + numSamples)});
+    }
+
+    return signals;
+}
+
+std::vector<NullTest::TestSignal> NullTest::makeSignals(double sampleRate) {
+    std::vector<TestSignal> signals;
+    auto pi = juce::MathConstants<double>::pi;
+
+    // Exponential sine sweep over the audio band, -12 dBFS
+    {
+        auto& sweep = signals.emplace_back(TestSignal {"sweep", std::vector<float>(getNumSamples(2.0, sampleRate))});
+        auto length = 2.0;
+        auto start = 20.0;
+        auto rate = std::log(juce::jmin(20000.0, 0.45 * sampleRate) / start);
+
+        for (size_t i = 0; i < sweep.samples.size(); ++i) {
+            auto phase = 2.0 * pi * start * length / rate * (std::exp((double) i / sampleRate * rate / length) - 1.0);
+            sweep.samples[i] = 0.25f * (float) std::sin(phase);
+        }
+    }
+
+    // Half scale, with time for the filters to ring out
+    {
+        auto& impulse = signals.emplace_back(TestSignal {"impulse", std::vector<float>(getNumSamples(0.5, sampleRate))});
+        impulse.samples[getNumSamples(0.05, sampleRate)] = 0.5f;
+    }
+
+    // Standing in for a DI: the six open strings plucked one after another,
+    // Karplus-Strong from the same noise every time
+    {
+        static constexpr double strings[] {82.41, 110.0, 146.83, 196.0, 246.94, 329.63};
+
+        auto noteLength = getNumSamples(0.4, sampleRate);
+        auto& pluck = signals.emplace_back(TestSignal {"pluck", std::vector<float>(noteLength * std::size(strings))});
+        juce::Random random(0x526f6b);
+
+        for (size_t note = 0; note < std::size(strings); ++note) {
+            std::vector<float> string((size_t) juce::jmax(2, juce::roundToInt(sampleRate / strings[note])));
+
+            for (auto& sample : string)
+                sample = 0.5f * (2.0f * random.nextFloat() - 1.0f);
+
+            for (size_t i = 0; i < noteLength; ++i) {
+                auto index = i % string.size();
+                auto sample = string[index];
+
+                string[index] = 0.996f * 0.5f * (sample + string[(index + 1) % string.size()]);
+                pluck.samples[note * noteLength + i] = sample;
+            }
+        }
+    }
+
+    signals.push_back({"silence", std::vector<float>(getNumSamples(0.5, sampleRate))});
+
+    // A step up to -12 dBFS after 10 ms
+    {
+        auto& dc = signals.emplace_back(TestSignal {"dc", std::vector<float>(getNumSamples(0.5, sampleRate))});
+        std::fill(dc.samples.begin() + (std::ptrdiff_t) getNumSamples(0.01, sampleRate), dc.samples.end(), 0.25f);
+    }
+
+    // White noise below the smallest normal float. Built here, outside the
+    // ScopedNoDenormals of runCase, so it really is denormal
+    {
+        auto& denormal = signals.emplace_back(TestSignal {"denormal", std::vector<float>(getNumSamples(0.5, sampleRate))});
+        juce::Random random(0x526f6b);
+
+        for (auto& sample : denormal.samples)
+            sample = (2.0f * random.nextFloat() - 1.0f) * 1.0e-39f;
+    }
+
+    return signals;
+}
+
+//==============================================================================
+void NullTest::run() {
+    for (auto mode : options.modes) {
+        for (auto sampleRate : options.sampleRates) {
+            std::cout << std::endl << modeNames[mode] << " @ " << juce::String(juce::roundToInt(sampleRate)) << " Hz" << std::endl;
+
+            std::cout << juce::String("signal").paddedRight(' ', 13) << juce::String("block").paddedLeft(' ', 6)
+                      << juce::String("max dBFS").paddedLeft(' ', 10) << juce::String("resid dB").paddedLeft(' ', 10)
+                      << juce::String("spec dB").paddedLeft(' ', 9) << juce::String("ref ns").paddedLeft(' ', 9)
+                      << juce::String("ns").paddedLeft(' ', 8) << juce::String("speedup").paddedLeft(' ', 9) << std::endl;
+
+            auto signals = makeSignals(sampleRate);
+            signals.insert(signals.end(), recordings.begin(), recordings.end());
+
+            for (auto& signal : signals)
+                for (auto blockSize : options.blockSizes)
+                    runCase(mode, sampleRate, blockSize, signal);
+        }
+    }
+
+    std::cout << std::endl;
+
+    for (auto sampleRate : options.sampleRates)
+        runEchoDecay(sampleRate);
+
+    // The worst of every mode and rate, and how much faster the engine was
+    std::cout << std::endl;
+
+    for (auto mode : options.modes) {
+        for (auto sampleRate : options.sampleRates) {
+            auto maxError = -200.0, spectral = 0.0, referenceTime = 0.0, engineTime = 0.0;
+
+            for (auto& result : results) {
+                if (result.mode != mode || result.sampleRate != sampleRate)
+                    continue;
+
+                maxError = juce::jmax(maxError, result.maxErrorDecibels);
+                spectral = juce::jmax(spectral, result.spectralDecibels);
+                referenceTime += result.referenceNanosecondsPerSample;
+                engineTime += result.engineNanosecondsPerSample;
+            }
+
+            auto& tolerance = options.tolerance;
+
+            std::cout << modeNames[mode] << " @ " << juce::String(juce::roundToInt(sampleRate)) << " Hz: max error " << juce::String(maxError, 1)
+                      << " dBFS (limit " << juce::String(tolerance.maxErrorDecibels, 1) << "), spectral " << juce::String(spectral, 3)
+                      << " dB (limit " << juce::String(tolerance.spectralDecibels, 3) << "), "
+                      << juce::String(engineTime > 0.0 ? referenceTime / engineTime : 0.0, 2) << "x the reference's speed" << std::endl;
+        }
+    }
+}
+
+void NullTest::runCase(int mode, double sampleRate, int blockSize, const TestSignal& signal) {
+    auto numSamples = (int) signal.samples.size();
+
+    // The right channel upside down, so the lanes differ and stay unlinked
+    juce::AudioBuffer<float> input(ReferenceChain::numChannels, numSamples);
+
+    for (int i = 0; i < numSamples; ++i) {
+        input.setSample(0, i, signal.samples[(size_t) i]);
+        input.setSample(1, i, -signal.samples[(size_t) i]);
+    }
+
+    // As in processBlock
+    juce::ScopedNoDenormals noDenormals;
+
+    // The float chain for its speed, the double one for what it should sound like
+    ReferenceChain reference;
+    reference.prepare(sampleRate, blockSize);
+    reference.setMode(mode);
+    reference.reset();
+
+    ReferenceChainDouble exactReference;
+    exactReference.prepare(sampleRate, blockSize);
+    exactReference.setMode(mode);
+    exactReference.reset();
+
+    auto settings = options.settings;
+    settings.mode = mode;
+
+    RokmanEngine engine;
+    engine.prepare(sampleRate, blockSize, ReferenceChain::numChannels);
+    engine.setChainSettings(settings);
+    engine.reset();
+
+    juce::AudioBuffer<float> referenceOutput, engineOutput;
+    referenceOutput.makeCopyOf(input);
+    engineOutput.makeCopyOf(input);
+
+    juce::AudioBuffer<double> exactOutput;
+    exactOutput.makeCopyOf(input);
+
+    NullTestResult result;
+    result.mode = mode;
+    result.sampleRate = sampleRate;
+    result.blockSize = blockSize;
+    result.signal = signal.name;
+    result.referenceNanosecondsPerSample = render(referenceOutput, blockSize, [&](juce::AudioBuffer<float>& block) { reference.process(block); });
+    result.engineNanosecondsPerSample = render(engineOutput, blockSize, [&](juce::AudioBuffer<float>& block) { engine.process(block); });
+    render(exactOutput, blockSize, [&](juce::AudioBuffer<double>& block) { exactReference.process(block); });
+
+    compare(exactOutput, engineOutput, engine.getLatencySamples(), result);
+
+    auto& tolerance = options.tolerance;
+    result.passed = result.maxErrorDecibels <= tolerance.maxErrorDecibels && result.spectralDecibels <= tolerance.spectralDecibels;
+    results.add(result);
+
+    auto speedup = result.engineNanosecondsPerSample > 0.0 ? result.referenceNanosecondsPerSample / result.engineNanosecondsPerSample : 0.0;
+
+    std::cout << signal.name.substring(0, 12).paddedRight(' ', 13) << juce::String(blockSize).paddedLeft(' ', 6)
+              << juce::String(result.maxErrorDecibels, 1).paddedLeft(' ', 10) << juce::String(result.residualDecibels, 1).paddedLeft(' ', 10)
+              << juce::String(result.spectralDecibels, 3).paddedLeft(' ', 9)
+              << juce::String(result.referenceNanosecondsPerSample, 2).paddedLeft(' ', 9)
+              << juce::String(result.engineNanosecondsPerSample, 2).paddedLeft(' ', 8)
+              << (juce::String(speedup, 1) + "x").paddedLeft(' ', 9) << (result.passed ? "" : "  FAIL") << std::endl;
+}
+
+void NullTest::runEchoDecay(double sampleRate) {
+    using Stage = ChorusEchoStage<float>;
+
+    // As in processBlock, the repeats end in zeros rather than denormals
+    juce::ScopedNoDenormals noDenormals;
+
+    Stage echo;
+    echo.setEchoEnabled(true);
+    echo.prepare({sampleRate, 512, 1});
+
+    auto tailLength = getNumSamples(Stage::getTailSeconds(true), sampleRate);
+    auto length = 3 * tailLength;
+    auto finalStart = length - getNumSamples(1.0, sampleRate);
+
+    // 50 ms of noise, an impulse alone is too sparse to leave a residue
+    auto burstLength = getNumSamples(0.05, sampleRate);
+    juce::Random random(0x526f6b);
+
+    std::vector<float> samples(512);
+    auto tailPeak = 0.0, finalPeak = 0.0;
+
+    for (size_t start = 0; start < length; start += samples.size()) {
+        for (size_t i = 0; i < samples.size(); ++i)
+            samples[i] = start + i < burstLength ? 0.5f * (2.0f * random.nextFloat() - 1.0f) : 0.0f;
+
+        auto* channel = samples.data();
+        juce::dsp::AudioBlock<float> block(&channel, 1, samples.size());
+        echo.process(juce::dsp::ProcessContextReplacing<float>(block));
+
+        for (size_t i = 0; i < samples.size(); ++i) {
+            auto magnitude = (double) std::abs(samples[i]);
+
+            if (start + i >= tailLength)
+                tailPeak = juce::jmax(tailPeak, magnitude);
+
+            if (start + i >= finalStart)
+                finalPeak = juce::jmax(finalPeak, magnitude);
+        }
+    }
+
+    EchoDecayResult result;
+    result.sampleRate = sampleRate;
+    result.tailDecibels = juce::Decibels::gainToDecibels(tailPeak, -200.0);
+    result.finalDecibels = juce::Decibels::gainToDecibels(finalPeak, -200.0);
+
+    // Another 120 dB down over twice the tail, the repeats alone fall much
+    // further than that
+    result.passed = tailPeak < RokmanEngine::silenceThreshold && finalPeak < RokmanEngine::silenceThreshold * 1.0e-6;
+    echoDecayResults.add(result);
+
+    std::cout << "Echo decay @ " << juce::String(juce::roundToInt(sampleRate)) << " Hz: " << juce::String(result.tailDecibels, 1)
+              << " dBFS after the tail, " << juce::String(result.finalDecibels, 1) << " dBFS at three times it"
+              << (result.passed ? "" : "  FAIL") << std::endl;
+}
+
+template <typename SampleType, typename Function>
+double NullTest::render(juce::AudioBuffer<SampleType>& buffer, int blockSize, Function&& processBlock) {
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (int position = 0; position < buffer.getNumSamples(); position += blockSize) {
+        auto numSamples = juce::jmin(blockSize, buffer.getNumSamples() - position);
+
+        // The host's buffer for this block, nothing is copied
+        juce::AudioBuffer<SampleType> block(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), position, numSamples);
+        processBlock(block);
+    }
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    return seconds * 1.0e9 / juce::jmax(1, buffer.getNumSamples());
+}
+
+void NullTest::compare(const juce::AudioBuffer<double>& reference, const juce::AudioBuffer<float>& output, int latency, NullTestResult& result) {
+    auto numSamples = reference.getNumSamples() - latency;
+
+    if (numSamples <= 0)
+        return;
+
+    double maxError = 0.0, errorPower = 0.0, referencePower = 0.0;
+
+    for (int channel = 0; channel < reference.getNumChannels(); ++channel) {
+        auto* expected = reference.getReadPointer(channel);
+        auto* actual = output.getReadPointer(channel, latency);
+
+        for (int i = 0; i < numSamples; ++i) {
+            auto error = (double) actual[i] - (double) expected[i];
+            maxError = juce::jmax(maxError, std::abs(error));
+            errorPower += error * error;
+            referencePower += (double) expected[i] * (double) expected[i];
+        }
+    }
+
+    result.maxErrorDecibels = juce::Decibels::gainToDecibels(maxError, -200.0);
+
+    // The reference's power is floored at -200 dBFS, silence would divide by 0
+    auto floor = 1.0e-20 * numSamples * reference.getNumChannels();
+
+    if (errorPower > 0.0)
+        result.residualDecibels = juce::jmax(-200.0, 10.0 * std::log10(errorPower / juce::jmax(referencePower, floor)));
+
+    // The right channel mirrors the left, one spectrum says it all
+    auto expectedBands = getBandLevels(averageSpectrum(reference.getReadPointer(0), numSamples), result.sampleRate);
+    auto actualBands = getBandLevels(averageSpectrum(output.getReadPointer(0, latency), numSamples), result.sampleRate);
+    auto loudest = *std::max_element(expectedBands.begin(), expectedBands.end());
+
+    // Nothing to compare in silence, the max error covers it
+    if (loudest < 1.0e-20)
+        return;
+
+    for (size_t band = 0; band < expectedBands.size(); ++band) {
+        if (expectedBands[band] < loudest * 1.0e-4)
+            continue;
+
+        auto difference = 10.0 * std::log10((actualBands[band] + loudest * 1.0e-12) / expectedBands[band]);
+        result.spectralDecibels = juce::jmax(result.spectralDecibels, std::abs(difference));
+    }
+}
+
+template <typename SampleType>
+std::vector<double> NullTest::averageSpectrum(const SampleType* samples, int numSamples) {
+    juce::dsp::FFT fft(fftOrder);
+    juce::dsp::WindowingFunction<float> window((size_t) fftSize, juce::dsp::WindowingFunction<float>::hann);
+
+    std::vector<float> frame((size_t) fftSize * 2);
+    std::vector<double> power((size_t) fftSize / 2 + 1, 0.0);
+    int numFrames = 0;
+
+    // At least one frame, zero padded if the signal is shorter
+    for (int start = 0; start == 0 || start + fftSize <= numSamples; start += fftSize / 2) {
+        std::fill(frame.begin(), frame.end(), 0.0f);
+        std::copy(samples + start, samples + juce::jmin(numSamples, start + fftSize), frame.begin());
+
+        window.multiplyWithWindowingTable(frame.data(), (size_t) fftSize);
+        fft.performFrequencyOnlyForwardTransform(frame.data());
+
+        for (size_t k = 0; k < power.size(); ++k)
+            power[k] += (double) frame[k] * (double) frame[k];
+
+        ++numFrames;
+    }
+
+    for (auto& bin : power)
+        bin /= numFrames;
+
+    return power;
+}
+
+std::vector<double> NullTest::getBandLevels(const std::vector<double>& spectrum, double sampleRate) {
+    std::vector<double> bands;
+    auto binWidth = sampleRate / fftSize;
+
+    // Third octaves from 20 Hz, every bin in exactly one band
+    for (auto centre = 20.0; centre * std::pow(2.0, -1.0 / 6.0) < sampleRate * 0.5; centre *= std::pow(2.0, 1.0 / 3.0)) {
+        auto first = (size_t) std::ceil(centre * std::pow(2.0, -1.0 / 6.0) / binWidth);
+        auto end = juce::jmin(spectrum.size(), (size_t) std::ceil(centre * std::pow(2.0, 1.0 / 6.0) / binWidth));
+
+        if (first < end)
+            bands.push_back(std::accumulate(spectrum.begin() + (std::ptrdiff_t) first, spectrum.begin() + (std::ptrdiff_t) end, 0.0));
+    }
+
+    return bands;
+}
+
+//==============================================================================
+int NullTest::getNumFailed() const {
+    int numFailed = 0;
+
+    for (auto& result : results)
+        if (! result.passed)
+            ++numFailed;
+
+    for (auto& result : echoDecayResults)
+        if (! result.passed)
+            ++numFailed;
+
+    return numFailed;
+}
+
+juce::var NullTest::toJSON() const {
+    auto* settings = new juce::DynamicObject();
+    settings->setProperty("oversampling", options.settings.oversampling);
+    settings->setProperty("oversamplingFilter", options.settings.oversamplingFilter);
+    settings->setProperty("clipper", options.settings.clipper);
+    settings->setProperty("antialiasing", options.settings.antialiasing);
+
+    juce::Array<juce::var> cases;
+
+    for (auto& result : results) {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("key", result.getKey());
+        object->setProperty("maxErrorDb", result.maxErrorDecibels);
+        object->setProperty("residualDb", result.residualDecibels);
+        object->setProperty("spectralDb", result.spectralDecibels);
+        object->setProperty("referenceNsPerSample", result.referenceNanosecondsPerSample);
+        object->setProperty("nsPerSample", result.engineNanosecondsPerSample);
+        object->setProperty("passed", result.passed);
+        cases.add(juce::var(object));
+    }
+
+    juce::Array<juce::var> echoDecay;
+
+    for (auto& result : echoDecayResults) {
+        auto* object = new juce::DynamicObject();
+        object->setProperty("sampleRate", result.sampleRate);
+        object->setProperty("tailDb", result.tailDecibels);
+        object->setProperty("finalDb", result.finalDecibels);
+        object->setProperty("passed", result.passed);
+        echoDecay.add(juce::var(object));
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("settings", juce::var(settings));
+    root->setProperty("results", cases);
+    root->setProperty("echoDecay", echoDecay);
+
+    return juce::var(root);
+}
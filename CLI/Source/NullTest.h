@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    NullTest.h
+
+    Renders a fixed set of test signals through ReferenceChainDouble and
+    through RokmanEngine, for every mode, sample rate and block size asked
+    for, and checks the engine against the reference:
+
+        max error   largest sample difference, dBFS
+        residual    RMS of the difference against the RMS of the reference
+        spectral    largest difference between the third octave band levels
+                    of the two, dB, over the bands within 40 dB of the
+                    reference's loudest
+
+    Max error and spectral are held against one error budget, NullTolerance.
+    The engine is timed against the float ReferenceChain on the same blocks,
+    so one report shows what an optimisation costs in accuracy next to what
+    it saves.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/RokmanEngine.h"
+#include "ReferenceChain.h"
+
+// What the float engine may differ from the double reference by. Float
+// keeps 24 bits, so each rounding is within 2^-24 of the value rounded. The
+// longest path, the HPF, the compressor's gain and two runs of four EQ
+// sections, rounds a sample fewer than 200 times, at levels up to 2 referred
+// to the output: 2^-24 * 200 * 2 is -92.5 dBFS if they all added up.
+// Coefficient interpolation adds nothing to it, the reference has no Tone or
+// HPF control and at 0 every section is a designed table point, which
+// interpolate hands back exactly. An error that size moves a band 40 dB
+// under the loudest of a -12 dBFS test signal by 0.08 dB
+struct NullTolerance {
+    static constexpr double roundingError = 200.0 * 2.0 / (1 << 24);
+    static constexpr double quietestBand = 0.25 * 0.01;
+
+    double maxErrorDecibels {juce::Decibels::gainToDecibels(roundingError)};
+    double spectralDecibels {juce::Decibels::gainToDecibels(1.0 + roundingError / quietestBand)};
+};
+
+struct NullTestOptions {
+    // Clipper, antialiasing and oversampling, the mode comes from modes
+    // below. The reference only has the hard clip at 1x, anything else is
+    // measured against it too
+    ChainSettings settings;
+
+    juce::Array<int> modes {CoefficientBank::Dist, CoefficientBank::Edge, CoefficientBank::Cln1, CoefficientBank::Cln2};
+    juce::Array<int> blockSizes {16, 128, 1000, 4096};
+    juce::Array<double> sampleRates {44100.0, 48000.0, 96000.0};
+
+    // DI recordings run along with the generated signals, first channel
+    // only, at every rate as they are
+    juce::Array<juce::File> recordings;
+
+    // For every mode and rate, the rounding doesn't depend on either
+    NullTolerance tolerance;
+};
+
+struct NullTestResult {
+    int mode {0};
+    double sampleRate {0.0};
+    int blockSize {0};
+    juce::String signal;
+
+    double maxErrorDecibels {-200.0};
+    double residualDecibels {-200.0};
+    double spectralDecibels {0.0};
+
+    double referenceNanosecondsPerSample {0.0};
+    double engineNanosecondsPerSample {0.0};
+
+    bool passed {true};
+
+    juce::String getKey() const;
+};
+
+// DELAY 1 with only the echo on, fed a short burst. Its repeats have to be
+// under RokmanEngine::silenceThreshold once the reported tail is over, and
+// keep falling from there instead of settling on a residue
+struct EchoDecayResult {
+    double sampleRate {0.0};
+
+    // Peak after the tail, and over the last second of three times the tail
+    double tailDecibels {-200.0};
+    double finalDecibels {-200.0};
+
+    bool passed {true};
+};
+
+class NullTest {
+public:
+    explicit NullTest(const NullTestOptions& options);
+
+    // Runs every case and prints a table as it goes
+    void run();
+
+    const juce::Array<NullTestResult>& getResults() const { return results; }
+    const juce::Array<EchoDecayResult>& getEchoDecayResults() const { return echoDecayResults; }
+    int getNumFailed() const;
+
+    juce::var toJSON() const;
+
+private:
+    struct TestSignal {
+        juce::String name;
+        std::vector<float> samples;
+    };
+
+    NullTestOptions options;
+    juce::Array<NullTestResult> results;
+    juce::Array<EchoDecayResult> echoDecayResults;
+    std::vector<TestSignal> recordings;
+
+    // Sweep, impulse, plucked strings, silence, DC step and denormal noise,
+    // built for the rate
+    static std::vector<TestSignal> makeSignals(double sampleRate);
+    static std::vector<TestSignal> loadRecordings(const juce::Array<juce::File>& files);
+
+    void runCase(int mode, double sampleRate, int blockSize, const TestSignal& signal);
+    void runEchoDecay(double sampleRate);
+
+    // Hands the buffer over in blocks the way a host would, returns ns per
+    // sample
+    template <typename SampleType, typename Function>
+    static double render(juce::AudioBuffer<SampleType>& buffer, int blockSize, Function&& processBlock);
+
+    static void compare(const juce::AudioBuffer<double>& reference, const juce::AudioBuffer<float>& output, int latency, NullTestResult& result);
+
+    // Hann-windowed power spectrum, averaged over half-overlapping frames
+    template <typename SampleType>
+    static std::vector<double> averageSpectrum(const SampleType* samples, int numSamples);
+    static std::vector<double> getBandLevels(const std::vector<double>& spectrum, double sampleRate);
+
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;
+};
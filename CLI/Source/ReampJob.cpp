@@ -0,0 +1,290 @@
+/*
+  ==============================================================================
+
+    ReampJob.cpp
+
+  ==============================================================================
+*/
+
+#include "ReampJob.h"
+
+namespace {
+
+// Runs a reader through the engine from any position, with the oversampling
+// latency taken out: output sample n lines up with input sample n. The
+// preRoll samples before startSample are rendered and thrown away
+class Renderer {
+public:
+    Renderer(juce::AudioFormatReader& newReader, const ReampOptions& options, juce::int64 startSample, juce::int64 preRoll)
+        : reader(newReader), blockSize(options.blockSize), buffer((int) newReader.numChannels, options.blockSize) {
+        // Same order as RokmanAudioProcessor::prepareToPlay
+        engine.prepare(reader.sampleRate, blockSize, buffer.getNumChannels());
+        engine.setChainSettings(options.settings);
+        engine.reset();
+
+        readPosition = startSample - preRoll;
+        engine.setStartPosition(readPosition);
+
+        // The latency is flushed out with silence past the end of the file
+        samplesToSkip = preRoll + engine.getLatencySamples();
+    }
+
+    // The next numSamples samples of output
+    void render(juce::AudioBuffer<float>& destination, int destinationStart, int numSamples) {
+        while (numSamples > 0) {
+            if (numReady == 0) {
+                // Past the end of the file the reader fills in zeros
+                reader.read(&buffer, 0, blockSize, readPosition, true, true);
+                readPosition += blockSize;
+
+                engine.process(buffer);
+
+                auto skipped = (int) juce::jmin(samplesToSkip, (juce::int64) blockSize);
+                samplesToSkip -= skipped;
+                readyPosition = skipped;
+                numReady = blockSize - skipped;
+                continue;
+            }
+
+            auto numToCopy = juce::jmin(numSamples, numReady);
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                destination.copyFrom(channel, destinationStart, buffer, channel, readyPosition, numToCopy);
+
+            readyPosition += numToCopy;
+            numReady -= numToCopy;
+            destinationStart += numToCopy;
+            numSamples -= numToCopy;
+        }
+    }
+
+private:
+    juce::AudioFormatReader& reader;
+    const int blockSize;
+
+    ModeSwitcher engine;
+    juce::AudioBuffer<float> buffer;
+
+    juce::int64 readPosition {0}, samplesToSkip {0};
+
+    // Rendered samples in buffer that haven't been handed out yet
+    int readyPosition {0}, numReady {0};
+};
+
+} // namespace
+
+//==============================================================================
+// One chunk of a file, with its own reader and engine
+class ReampJob::ChunkJob : public juce::ThreadPoolJob {
+public:
+    ChunkJob(std::unique_ptr<juce::AudioFormatReader> newReader, const ReampOptions& newOptions,
+             juce::int64 newStartSample, int newNumSamples, juce::int64 newPreRoll)
+        : juce::ThreadPoolJob("Reamp chunk"), reader(std::move(newReader)), options(newOptions),
+          startSample(newStartSample), numSamples(newNumSamples), preRoll(newPreRoll) {}
+
+    JobStatus runJob() override {
+        juce::ScopedNoDenormals noDenormals;
+
+        if (reader != nullptr) {
+            output.setSize((int) reader->numChannels, numSamples);
+
+            Renderer renderer(*reader, options, startSample, preRoll);
+            renderer.render(output, 0, numSamples);
+
+            // Every chunk maps the file, only the running ones need to
+            reader.reset();
+        }
+
+        return jobHasFinished;
+    }
+
+    // Empty if the file couldn't be opened
+    juce::AudioBuffer<float> output;
+
+private:
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    ReampOptions options;
+    juce::int64 startSample;
+    int numSamples;
+    juce::int64 preRoll;
+};
+
+//==============================================================================
+ReampJob::ReampJob(const juce::File& input, const ReampOptions& newOptions, juce::ThreadPool* newChunkPool)
+    : juce::ThreadPoolJob("Reamp " + input.getFileName()), options(newOptions), chunkPool(newChunkPool) {
+    result.input = input;
+    result.output = getOutputFile();
+}
+
+juce::File ReampJob::getOutputFile() const {
+    auto folder = options.outputFolder == juce::File() ? result.input.getParentDirectory() : options.outputFolder;
+    return folder.getChildFile(result.input.getFileNameWithoutExtension() + options.suffix + result.input.getFileExtension());
+}
+
+juce::ThreadPoolJob::JobStatus ReampJob::runJob() {
+    juce::ScopedNoDenormals noDenormals;
+
+    auto start = juce::Time::getMillisecondCounterHiRes();
+    render();
+    result.seconds = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+    return jobHasFinished;
+}
+
+std::unique_ptr<juce::AudioFormatReader> ReampJob::createReader(juce::AudioFormatManager& formats) const {
+    // WAV and AIFF can be mapped, the OS pages the file in as it is read
+    if (auto* format = formats.findFormatForFileExtension(result.input.getFileExtension())) {
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(format->createMemoryMappedReader(result.input));
+
+        if (mapped != nullptr && mapped->mapEntireFile())
+            return mapped;
+    }
+
+    return std::unique_ptr<juce::AudioFormatReader>(formats.createReaderFor(result.input));
+}
+
+void ReampJob::render() {
+    if (result.output == result.input) {
+        result.error = "output would overwrite the input";
+        return;
+    }
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    auto reader = createReader(formats);
+
+    if (reader == nullptr) {
+        result.error = "can't read this file";
+        return;
+    }
+
+    auto numChannels = (int) reader->numChannels;
+
+    if (numChannels < 1 || numChannels > RokmanEngine::getMaximumNumChannels()) {
+        result.error = "unsupported number of channels: " + juce::String(numChannels);
+        return;
+    }
+
+    auto* format = formats.findFormatForFileExtension(result.output.getFileExtension());
+
+    if (format == nullptr) {
+        result.error = "can't write " + result.output.getFileExtension() + " files";
+        return;
+    }
+
+    auto bitsPerSample = format->getPossibleBitDepths().contains((int) reader->bitsPerSample) ? (int) reader->bitsPerSample : 24;
+
+    result.output.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream(result.output.createOutputStream());
+
+    if (stream == nullptr) {
+        result.error = "can't write " + result.output.getFullPathName();
+        return;
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), reader->sampleRate, (unsigned int) numChannels,
+                                                                            bitsPerSample, reader->metadataValues, 0));
+
+    if (writer == nullptr) {
+        result.error = "can't write this format";
+        return;
+    }
+
+    // The writer owns the stream now
+    stream.release();
+
+    result.sampleRate = reader->sampleRate;
+    result.numSamples = reader->lengthInSamples;
+
+    if (chunkPool != nullptr && options.chunkSeconds > 0.0)
+        renderChunked(*reader, *writer);
+    else
+        renderSerial(*reader, *writer);
+}
+
+void ReampJob::renderSerial(juce::AudioFormatReader& reader, juce::AudioFormatWriter& writer) {
+    Renderer renderer(reader, options, 0, 0);
+    juce::AudioBuffer<float> buffer((int) reader.numChannels, options.blockSize);
+
+    for (juce::int64 position = 0; position < result.numSamples; position += options.blockSize) {
+        auto numSamples = (int) juce::jmin((juce::int64) options.blockSize, result.numSamples - position);
+        renderer.render(buffer, 0, numSamples);
+
+        if (! writer.writeFromAudioSampleBuffer(buffer, 0, numSamples)) {
+            result.error = "write failed";
+            return;
+        }
+    }
+}
+
+void ReampJob::renderChunked(juce::AudioFormatReader& reader, juce::AudioFormatWriter& writer) {
+    auto chunkLength = (juce::int64) juce::jmax(options.blockSize, juce::roundToInt(options.chunkSeconds * reader.sampleRate));
+    auto preRoll = (juce::int64) std::ceil((options.preRollSeconds + RokmanEngine::getTailLengthSeconds(options.settings)) * reader.sampleRate);
+
+    result.numChunks = (int) ((result.numSamples + chunkLength - 1) / chunkLength);
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    // Enough chunks are queued to keep every thread busy while the oldest
+    // one is written, so memory stays bounded however long the file is
+    juce::OwnedArray<ChunkJob> chunks;
+    auto maximumAhead = chunkPool->getNumThreads() + 1;
+
+    auto queue = [&](int chunk) {
+        auto start = chunk * chunkLength;
+        auto length = (int) juce::jmin(chunkLength, result.numSamples - start);
+
+        // The first chunk starts where the serial render does
+        auto* job = chunks.add(new ChunkJob(createReader(formats), options, start, length, juce::jmin(preRoll, start)));
+        chunkPool->addJob(job, false);
+    };
+
+    // Runs alongside, on this thread
+    std::unique_ptr<Renderer> serial;
+    juce::AudioBuffer<float> reference;
+
+    if (options.verifyChunks) {
+        serial = std::make_unique<Renderer>(reader, options, 0, 0);
+        result.chunkError = 0.0;
+    }
+
+    for (int chunk = 0; chunk < result.numChunks; ++chunk) {
+        while (chunks.size() < juce::jmin(result.numChunks, chunk + maximumAhead))
+            queue(chunks.size());
+
+        auto* job = chunks[chunk];
+        chunkPool->waitForJobToFinish(job, -1);
+
+        auto& output = job->output;
+
+        if (output.getNumChannels() == 0) {
+            result.error = "can't read this file";
+        } else if (! writer.writeFromAudioSampleBuffer(output, 0, output.getNumSamples())) {
+            result.error = "write failed";
+        } else if (serial != nullptr) {
+            reference.setSize(output.getNumChannels(), output.getNumSamples(), false, false, true);
+            serial->render(reference, 0, output.getNumSamples());
+
+            for (int channel = 0; channel < output.getNumChannels(); ++channel) {
+                auto* chunked = output.getReadPointer(channel);
+                auto* serialSamples = reference.getReadPointer(channel);
+
+                for (int i = 0; i < output.getNumSamples(); ++i)
+                    result.chunkError = juce::jmax(result.chunkError, (double) std::abs(chunked[i] - serialSamples[i]));
+            }
+        }
+
+        // Written, only the slot is kept
+        chunks.set(chunk, nullptr, true);
+
+        if (result.error.isNotEmpty()) {
+            for (auto* queued : chunks)
+                if (queued != nullptr)
+                    chunkPool->removeJob(queued, true, -1);
+
+            return;
+        }
+    }
+}
@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    ReampJob.h
+
+    Runs one file through the Rokman engine, set up the same way the plugin
+    sets it up in prepareToPlay, and writes the result. The file is read and
+    written in fixed blocks so its size doesn't matter; WAV and AIFF inputs
+    are memory-mapped.
+
+    A long file can also be split into chunks that render in parallel. Each
+    chunk starts early by a pre-roll that is rendered and thrown away, long
+    enough for the filters, the compressor and the echo to forget where they
+    started, so the chunks join up with the serial render.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/ModeSwitcher.h"
+
+struct ReampOptions {
+    ChainSettings settings;
+
+    // Empty writes next to the input
+    juce::File outputFolder;
+    juce::String suffix {"_rokman"};
+
+    int blockSize {4096};
+
+    // Chunks of this many seconds, 0 renders the file in one go
+    double chunkSeconds {0.0};
+
+    // Pre-roll of every chunk but the first, the echo's decay comes on top
+    double preRollSeconds {1.0};
+
+    // Chunked renders also run serially and measure the difference
+    bool verifyChunks {false};
+};
+
+struct ReampResult {
+    juce::File input, output;
+    juce::String error;
+
+    juce::int64 numSamples {0};
+    double sampleRate {0.0};
+    double seconds {0.0};
+
+    int numChunks {1};
+
+    // Largest difference between the chunked and the serial render, as a
+    // gain. Negative when it wasn't measured
+    double chunkError {-1.0};
+
+    bool wasOk() const { return error.isEmpty(); }
+    double getAudioSeconds() const { return sampleRate > 0.0 ? (double) numSamples / sampleRate : 0.0; }
+    double getRealtimeFactor() const { return seconds > 0.0 ? getAudioSeconds() / seconds : 0.0; }
+    double getSamplesPerSecond() const { return seconds > 0.0 ? (double) numSamples / seconds : 0.0; }
+};
+
+class ReampJob : public juce::ThreadPoolJob {
+public:
+    // With a pool, the file is rendered in chunks on it when options ask for
+    // that. runJob then has to run on a thread outside the pool
+    ReampJob(const juce::File& input, const ReampOptions& options, juce::ThreadPool* chunkPool = nullptr);
+
+    JobStatus runJob() override;
+
+    // Only valid once the pool has finished the job
+    const ReampResult& getResult() const { return result; }
+
+    juce::File getOutputFile() const;
+
+private:
+    class ChunkJob;
+
+    ReampOptions options;
+    ReampResult result;
+    juce::ThreadPool* chunkPool;
+
+    std::unique_ptr<juce::AudioFormatReader> createReader(juce::AudioFormatManager& formats) const;
+    void render();
+    void renderSerial(juce::AudioFormatReader& reader, juce::AudioFormatWriter& writer);
+    void renderChunked(juce::AudioFormatReader& reader, juce::AudioFormatWriter& writer);
+
+    JUCE_DECLARE_NON_COPYABLE(ReampJob)
+};
@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+    ReferenceChain.cpp
+
+  ==============================================================================
+*/
+
+#include "ReferenceChain.h"
+
+namespace {
+
+// The stages each mode bypassed, from the switch in processBlock. Columns in
+// ChainPositions order: HPF, Comp, HBEQ, MBPF, OPAMP, AD, OPAMP2, LBEQ, CF, DEL1
+constexpr bool bypassed[4][10] = {
+    {false, false, true,  false, false, false, false, true,  false, false},    // Dist
+    {false, false, false, false, false, false, false, true,  false, false},    // Edge
+    {false, false, false, true,  true,  true,  true,  true,  false, false},    // Cln1
+    {false, false, false, true,  true,  true,  true,  false, true,  false}     // Cln2
+};
+
+} // namespace
+
+template <typename SampleType>
+void BasicReferenceChain<SampleType>::prepare(double newSampleRate, int newMaximumBlockSize) {
+    sampleRate = newSampleRate;
+    maximumBlockSize = juce::jmax(1, newMaximumBlockSize);
+
+    juce::dsp::ProcessSpec spec;
+    spec.maximumBlockSize = (juce::uint32) maximumBlockSize;
+    spec.numChannels = 1;
+    spec.sampleRate = sampleRate;
+
+    for (auto& chain : chains) {
+        chain.prepare(spec);
+        update(chain);
+    }
+}
+
+template <typename SampleType>
+void BasicReferenceChain<SampleType>::reset() {
+    for (auto& chain : chains)
+        chain.reset();
+}
+
+template <typename SampleType>
+void BasicReferenceChain<SampleType>::setMode(int newMode) {
+    mode = juce::jlimit(0, 3, newMode);
+
+    for (auto& chain : chains)
+        update(chain);
+}
+
+template <typename SampleType>
+void BasicReferenceChain<SampleType>::process(juce::AudioBuffer<SampleType>& buffer) {
+    juce::dsp::AudioBlock<SampleType> block(buffer);
+    auto channels = juce::jmin((size_t) numChannels, block.getNumChannels());
+
+    for (size_t start = 0; start < block.getNumSamples(); start += (size_t) maximumBlockSize) {
+        auto subBlock = block.getSubBlock(start, juce::jmin((size_t) maximumBlockSize, block.getNumSamples() - start));
+
+        for (size_t channel = 0; channel < channels; ++channel) {
+            auto channelBlock = subBlock.getSingleChannelBlock(channel);
+            juce::dsp::ProcessContextReplacing<SampleType> context(channelBlock);
+            chains[channel].process(context);
+        }
+    }
+}
+
+template <typename SampleType>
+void BasicReferenceChain<SampleType>::update(MonoChain& chain) const {
+    using Coefficients = juce::dsp::IIR::Coefficients<SampleType>;
+
+    auto driven = mode == 0 || mode == 1;
+
+    // HPF 11
+    *chain.template get<ChainPositions::HPF>().coefficients = *Coefficients::makeFirstOrderHighPass(sampleRate, driven ? 10000.0f : 5000.0f);
+
+    // Compressor 12
+    auto& comp = chain.template get<ChainPositions::Comp>();
+    comp.setRatio(20.0);
+    comp.setRelease(50.0);
+    comp.setAttack(20.0);
+    comp.setThreshold(35.0);
+
+    // HPF 12.A & 13
+    *chain.template get<ChainPositions::HBEQ>().coefficients = *Coefficients::makeHighShelf(sampleRate, 4000.0, 1.30, 4.0);
+
+    // MBPF 14
+    auto& mbpf = chain.template get<ChainPositions::MBPF>();
+    *mbpf.template get<0>().coefficients = *Coefficients::makeFirstOrderHighPass(sampleRate, 800.0);
+    *mbpf.template get<1>().coefficients = *Coefficients::makeFirstOrderLowPass(sampleRate, 5000.0);
+    mbpf.template setBypassed<0>(false);
+    mbpf.template setBypassed<1>(false);
+
+    // LBEQ 15
+    *chain.template get<ChainPositions::LBEQ>().coefficients = *Coefficients::makeLowShelf(sampleRate, 50, 0.6, 4.8);
+
+    // OPAMP 16
+    chain.template get<ChainPositions::OPAMP>().setGainDecibels(43.07f);
+
+    // AD 16
+    chain.template get<ChainPositions::AD>().functionToUse = [] (SampleType x) {
+        return juce::jlimit (SampleType (-1.4), SampleType (1.4), 35*x);
+    };
+
+    // OPAMP2 16
+    chain.template get<ChainPositions::OPAMP2>().setGainDecibels(-43.07f);
+
+    // CF 17
+    auto cfLPCoeff = juce::dsp::FilterDesign<SampleType>::designIIRLowpassHighOrderButterworthMethod(4000, sampleRate, 2);
+
+    auto& cf = chain.template get<ChainPositions::CF>();
+    *cf.template get<0>().coefficients = *Coefficients::makeLowShelf(sampleRate, 80, 1, 3.5);
+    *cf.template get<1>().coefficients = *Coefficients::makePeakFilter(sampleRate, 1600, 2.80, 0.1);
+    *cf.template get<2>().coefficients = *cfLPCoeff[0];
+    cf.template setBypassed<0>(false);
+    cf.template setBypassed<1>(false);
+    cf.template setBypassed<2>(false);
+
+    // DELAY 1. fortyMS was worked out before there was a sample rate, so the
+    // delay was always 0
+    chain.template get<ChainPositions::DEL1>().setDelay(SampleType(0));
+
+    const auto& flags = bypassed[mode];
+    chain.template setBypassed<ChainPositions::HPF>(flags[ChainPositions::HPF]);
+    chain.template setBypassed<ChainPositions::Comp>(flags[ChainPositions::Comp]);
+    chain.template setBypassed<ChainPositions::HBEQ>(flags[ChainPositions::HBEQ]);
+    chain.template setBypassed<ChainPositions::MBPF>(flags[ChainPositions::MBPF]);
+    chain.template setBypassed<ChainPositions::OPAMP>(flags[ChainPositions::OPAMP]);
+    chain.template setBypassed<ChainPositions::AD>(flags[ChainPositions::AD]);
+    chain.template setBypassed<ChainPositions::OPAMP2>(flags[ChainPositions::OPAMP2]);
+    chain.template setBypassed<ChainPositions::LBEQ>(flags[ChainPositions::LBEQ]);
+    chain.template setBypassed<ChainPositions::CF>(flags[ChainPositions::CF]);
+    chain.template setBypassed<ChainPositions::DEL1>(flags[ChainPositions::DEL1]);
+}
+
+template class BasicReferenceChain<float>;
+template class BasicReferenceChain<double>;
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    ReferenceChain.h
+
+    The Rokman chain the way it was first written: a ProcessorChain of stock
+    juce::dsp processors per channel, every stage present in every mode and
+    switched off with bypass flags. The null test renders it next to
+    RokmanEngine, so an optimisation that changes the sound shows up.
+
+    Keep it as it is. It is slow on purpose, and any change to it moves the
+    reference every later optimisation is held against.
+
+    ReferenceChain is the chain as it ran, in float, and only the speed of
+    the engine is measured against it. Its accuracy is measured against
+    ReferenceChainDouble, the same chain with its filters designed and run
+    in double: the float chain's own rounding is larger than the engine's
+    at the higher rates, and would hide it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template <typename SampleType>
+class BasicReferenceChain {
+public:
+    // Allocates
+    void prepare(double sampleRate, int maximumBlockSize);
+    void reset();
+
+    // 0 = Dist, 1 = Edge, 2 = Cln1, 3 = Cln2
+    void setMode(int mode);
+
+    // Processes the first numChannels channels of the buffer in place, in
+    // blocks of at most maximumBlockSize
+    void process(juce::AudioBuffer<SampleType>& buffer);
+
+    static constexpr int numChannels = 2;
+
+private:
+    using Filter = juce::dsp::IIR::Filter<SampleType>;
+    using Compressor = juce::dsp::Compressor<SampleType>;
+    using WaveShaper = juce::dsp::WaveShaper<SampleType>;
+    using Gain = juce::dsp::Gain<SampleType>;
+    using MidBandPassFilter = juce::dsp::ProcessorChain<Filter, Filter>;
+    using ComplexFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter>;
+    using DelayLine = juce::dsp::DelayLine<SampleType>;
+    using MonoChain = juce::dsp::ProcessorChain<Filter, Compressor, Filter, MidBandPassFilter, Gain, WaveShaper, Gain, Filter, ComplexFilter, DelayLine>;
+
+    // leftChannel and rightChannel
+    std::array<MonoChain, numChannels> chains;
+
+    enum ChainPositions {
+        HPF,
+        Comp,
+        HBEQ,
+        MBPF,
+        OPAMP,
+        AD,
+        OPAMP2,
+        LBEQ,
+        CF,
+        DEL1,
+        numChainPositions
+    };
+
+    double sampleRate {44100.0};
+    int maximumBlockSize {0};
+    int mode {0};
+
+    // Everything processBlock used to set on every block
+    void update(MonoChain& chain) const;
+};
+
+using ReferenceChain = BasicReferenceChain<float>;
+using ReferenceChainDouble = BasicReferenceChain<double>;
+
+extern template class BasicReferenceChain<float>;
+extern template class BasicReferenceChain<double>;
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    BatchEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "BatchEngine.h"
+
+void BatchEngine::prepare(double sampleRate, int maximumBlockSize, const juce::Array<ChainSettings>& voiceSettings) {
+    groups.clear();
+    voiceGroups.clearQuick();
+    numVoices = voiceSettings.size();
+
+    // The first group with the same settings and a free lane, or a new one
+    std::vector<ChainSettings> groupSettings;
+
+    for (int voice = 0; voice < numVoices; ++voice) {
+        auto& settings = voiceSettings.getReference(voice);
+        auto index = 0;
+
+        while (index < (int) groups.size()
+               && ! (groupSettings[(size_t) index] == settings && groups[(size_t) index]->voices.size() < getVoicesPerGroup()))
+            ++index;
+
+        if (index == (int) groups.size()) {
+            groups.push_back(std::make_unique<Group>());
+            groupSettings.push_back(settings);
+        }
+
+        groups[(size_t) index]->voices.add(voice);
+        voiceGroups.add(index);
+    }
+
+    for (size_t index = 0; index < groups.size(); ++index) {
+        auto& group = *groups[index];
+
+        // Same order as RokmanAudioProcessor::prepareToPlay
+        group.engine.setSubBlockSize(subBlockSize);
+        group.engine.prepare(sampleRate, maximumBlockSize, group.voices.size());
+        group.engine.setChainSettings(groupSettings[index]);
+
+        // The lanes are separate tracks, not the two sides of a stereo pair
+        for (int lane = 0; lane < getVoicesPerGroup(); ++lane)
+            group.engine.setChorusSign(lane, 1.0f);
+
+        group.engine.reset();
+    }
+}
+
+void BatchEngine::reset() {
+    for (auto& group : groups)
+        group->engine.reset();
+}
+
+void BatchEngine::process(juce::AudioBuffer<float>& buffer) {
+    jassert(buffer.getNumChannels() >= numVoices);
+
+    auto* channels = buffer.getArrayOfWritePointers();
+
+    for (auto& group : groups) {
+        // The group's voices as a buffer of their own, without copying them
+        std::array<float*, (size_t) getVoicesPerGroup()> lanes;
+        auto numLanes = 0;
+
+        for (auto voice : group->voices)
+            if (voice < buffer.getNumChannels())
+                lanes[(size_t) numLanes++] = channels[voice];
+
+        if (numLanes < group->voices.size())
+            continue;
+
+        juce::AudioBuffer<float> view(lanes.data(), numLanes, buffer.getNumSamples());
+        group->engine.process(view);
+    }
+}
+
+int BatchEngine::getLatencySamples(int voice) const {
+    if (! juce::isPositiveAndBelow(voice, numVoices))
+        return 0;
+
+    return groups[(size_t) voiceGroups[voice]]->engine.getLatencySamples();
+}
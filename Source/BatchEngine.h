@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    BatchEngine.h
+
+    Many independent mono voices (tracks) through the Rokman chain in one
+    pass, for offline rendering. Voices with the same ChainSettings share a
+    RokmanEngine, one voice per SIMD lane, so the filter and compressor
+    states and the coefficients of a group sit side by side in the same
+    registers and every stage runs once per sample for all of them.
+
+    Each voice keeps its own mode and settings, voices that differ go to
+    different groups. A group that isn't full runs with empty lanes. Every
+    lane adds the chorus, so a voice sounds the same whichever lane it gets.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "RokmanEngine.h"
+
+class BatchEngine {
+public:
+    // One entry per voice, voice i is channel i of the buffers. Allocates,
+    // call it before rendering only
+    void prepare(double sampleRate, int maximumBlockSize, const juce::Array<ChainSettings>& voiceSettings);
+    void reset();
+
+    // See RokmanEngine, set it before prepare
+    void setSubBlockSize(int numSamples) { subBlockSize = numSamples; }
+
+    // Every voice in place, the buffer needs a channel per voice
+    void process(juce::AudioBuffer<float>& buffer);
+
+    int getNumVoices() const { return numVoices; }
+    int getNumGroups() const { return (int) groups.size(); }
+
+    // Voices with other oversampling settings have other latencies
+    int getLatencySamples(int voice) const;
+
+    static constexpr int getVoicesPerGroup() { return RokmanEngine::getMaximumNumChannels(); }
+
+private:
+    struct Group {
+        RokmanEngine engine;
+
+        // Buffer channel of each lane
+        juce::Array<int> voices;
+    };
+
+    std::vector<std::unique_ptr<Group>> groups;
+
+    // Group index of every voice
+    juce::Array<int> voiceGroups;
+    int numVoices {0};
+    int subBlockSize {RokmanEngine::defaultSubBlockSize};
+};
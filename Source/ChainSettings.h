@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+
+    ChainSettings.h
+
+    The parameter values the engine is built from, shared by the plugin and
+    the command line tools.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+struct ChainSettings {
+    int mode {0};
+    int oversampling {0};
+    int oversamplingFilter {0};
+    int clipper {0};
+    int antialiasing {0};   // ADAA order for the hard clip and tanh, 0 is off
+    bool chorus {false};
+    bool echo {false};
+
+    // Continuous controls
+    float drive {0.0f};     // dB on top of OPAMP 16
+    float output {0.0f};    // dB
+    float hpf {0.0f};       // octaves HPF 11 is moved by
+    float tone {0.0f};      // octaves the EQ filters are moved by
+
+    bool operator==(const ChainSettings&) const = default;
+};
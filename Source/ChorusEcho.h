@@ -0,0 +1,339 @@
+/*
+  ==============================================================================
+
+    ChorusEcho.h
+
+    DELAY 1, the chorus and echo of the X100. Both run off DelayBuffers of
+    whole SIMD registers and every lane is delayed by the same amount, so a
+    tap is a plain load per interpolation point, no gather. By default the
+    chorus is added to even lanes and subtracted from odd ones, the way the
+    unit spreads a mono guitar across its two outputs; setChorusSign changes
+    that per lane.
+
+    The LFO and the on/off ramps are worked out for the whole block before
+    the sample loop, and the interpolation is a template parameter, so
+    nothing is picked per sample.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "RokmanDSP.h"
+
+namespace DelayInterpolation {
+
+//==============================================================================
+// Straight line between the two nearest samples. Cheap, but it dulls the top
+// end as the delay moves
+struct Linear {
+    template <typename SampleType, typename NumericType>
+    static SampleType read(const DelayBuffer<SampleType>& buffer, int delay, NumericType fraction) noexcept {
+        auto a = buffer.read(delay);
+        return a + (buffer.read(delay + 1) - a) * fraction;
+    }
+};
+
+// Third order Lagrange through delay - 1 ... delay + 2, flat much higher up
+// than Linear. delay has to be 1 or more
+struct Lagrange3 {
+    template <typename SampleType, typename NumericType>
+    static SampleType read(const DelayBuffer<SampleType>& buffer, int delay, NumericType fraction) noexcept {
+        const auto d = fraction;
+        const auto dm1 = d - NumericType(1);
+        const auto dm2 = d - NumericType(2);
+        const auto dp1 = d + NumericType(1);
+
+        const auto c0 = -d * dm1 * dm2 / NumericType(6);
+        const auto c1 = dp1 * dm1 * dm2 / NumericType(2);
+        const auto c2 = -dp1 * d * dm2 / NumericType(2);
+        const auto c3 = dp1 * d * dm1 / NumericType(6);
+
+        return buffer.read(delay - 1) * c0 + buffer.read(delay) * c1
+             + buffer.read(delay + 1) * c2 + buffer.read(delay + 2) * c3;
+    }
+};
+
+} // namespace DelayInterpolation
+
+//==============================================================================
+// Chorus: one tap swept by a sine LFO. Echo: one fixed tap fed back through
+// a lowpass, its fractional part through a first order allpass, which keeps
+// the repeats as bright as the lowpass lets them be
+template <typename SampleType, typename Interpolation = DelayInterpolation::Lagrange3>
+class ChorusEchoStage {
+public:
+    using NumericType = typename SampleTraits<SampleType>::NumericType;
+
+    // Real-time safe, both fade in and out over rampTime
+    void setChorusEnabled(bool shouldBeEnabled) noexcept { chorusTarget = shouldBeEnabled ? NumericType(1) : NumericType(0); }
+    void setEchoEnabled(bool shouldBeEnabled) noexcept { echoTarget = shouldBeEnabled ? NumericType(1) : NumericType(0); }
+
+    // Real-time safe, kept across prepare. 1 adds the chorus to the lane, -1
+    // subtracts it
+    void setChorusSign(size_t lane, NumericType sign) noexcept {
+        jassert(lane < SampleTraits<SampleType>::numLanes);
+        SampleTraits<SampleType>::setLane(laneSign, lane, sign);
+    }
+
+    // Every length is derived from the sample rate here
+    void prepare(const juce::dsp::ProcessSpec& spec) {
+        using Traits = SampleTraits<SampleType>;
+
+        sampleRate = spec.sampleRate;
+
+        chorusCentre = static_cast<NumericType>(chorusCentreTime * sampleRate / 1000.0);
+        chorusDepth = static_cast<NumericType>(chorusDepthTime * sampleRate / 1000.0);
+        lfoIncrement = juce::MathConstants<double>::twoPi * chorusRate / sampleRate;
+
+        // The echo tap is read before the sample is pushed, one sample later.
+        // The allpass takes 0.5 to 1.5 samples of the delay: at a fraction of
+        // 0, which every common rate gives, its pole would sit on z = -1 and
+        // rounding noise would ring at Nyquist for ever
+        auto echoDelay = juce::jmax(1.0, echoTime * sampleRate / 1000.0 - 1.0);
+        echoWhole = (int) std::floor(echoDelay - 0.5);
+        auto fraction = echoDelay - echoWhole;
+        echoAllpass = Traits::broadcast(static_cast<NumericType>((1.0 - fraction) / (1.0 + fraction)));
+
+        damping = Traits::broadcast(static_cast<NumericType>(1.0 - std::exp(-juce::MathConstants<double>::twoPi * echoDamping / sampleRate)));
+        rampStep = static_cast<NumericType>(1000.0 / (rampTime * sampleRate));
+
+        channels.resize(spec.numChannels);
+
+        for (auto& channel : channels) {
+            channel.chorus.setMaximumDelay((int) std::ceil(chorusCentre + chorusDepth) + 2);
+            channel.echo.setMaximumDelay(echoWhole + 1);
+        }
+
+        modulation.resize(spec.maximumBlockSize);
+        chorusGain.resize(spec.maximumBlockSize);
+        echoGain.resize(spec.maximumBlockSize);
+
+        reset();
+    }
+
+    void reset() noexcept {
+        for (auto& channel : channels) {
+            channel.chorus.clear();
+            channel.echo.clear();
+            channel.allpassIn = channel.allpassOut = channel.lowpass = SampleType();
+        }
+
+        lfoPhase = 0.0;
+        chorusLevel = chorusTarget;
+        echoLevel = echoTarget;
+    }
+
+    // Puts the LFO where it would be numSamples after reset, for renders that
+    // start partway into a file
+    void setLFOPosition(juce::int64 numSamples) noexcept {
+        lfoPhase = std::fmod(lfoIncrement * (double) numSamples, juce::MathConstants<double>::twoPi);
+    }
+
+    // Longest a sample stays in the buffers before it reaches the output
+    static double getMaximumDelaySeconds() noexcept {
+        return juce::jmax(chorusCentreTime + chorusDepthTime, echoTime) / 1000.0;
+    }
+
+    // Moves the LFO on as if numSamples had been processed, for blocks that
+    // are skipped
+    void skipLFO(size_t numSamples) noexcept {
+        lfoPhase = std::fmod(lfoPhase + lfoIncrement * (double) numSamples, juce::MathConstants<double>::twoPi);
+    }
+
+    // How long the output keeps going once the input stops: the chorus
+    // delay, and with the echo on its repeats down to floorDecibels
+    static double getTailSeconds(bool echoEnabled, double floorDecibels = -120.0) noexcept {
+        auto tail = (chorusCentreTime + chorusDepthTime) / 1000.0;
+
+        if (echoEnabled)
+            tail += std::ceil(floorDecibels / juce::Decibels::gainToDecibels(echoFeedback)) * echoTime / 1000.0;
+
+        return tail;
+    }
+
+    // Takes over the repeats of a stage prepared the same way, so a second
+    // engine carries on where the first one is. Everything but the echo
+    // history comes over here, the chorus buffer is only a few ms long.
+    // Nothing is cleared first: what isn't copied is never read
+    void startCopyFrom(const ChorusEchoStage& other) noexcept {
+        jassert(other.channels.size() == channels.size());
+
+        for (size_t i = 0; i < channels.size(); ++i) {
+            channels[i].chorus.copyFrom(other.channels[i].chorus);
+            channels[i].echo.setWritePosition(other.channels[i].echo.getWritePosition());
+            channels[i].allpassIn = other.channels[i].allpassIn;
+            channels[i].allpassOut = other.channels[i].allpassOut;
+            channels[i].lowpass = other.channels[i].lowpass;
+        }
+
+        lfoPhase = other.lfoPhase;
+        chorusLevel = other.chorusLevel;
+        echoLevel = other.echoLevel;
+
+        // Oldest first, from where the first tap reads up to the last push
+        echoCopyStart = channels.empty() ? 0 : channels[0].echo.getWritePosition() - echoWhole;
+        echoCopyRemaining = echoWhole + 1;
+        echoCopyDue = 0;
+    }
+
+    // The echo history, up to 1 MB at 192 kHz, a piece at a time. Call it
+    // before every block the two stages process, other having processed
+    // nothing else since startCopyFrom. Copies at least what the next
+    // numSamples read, and enough that the rest is over within
+    // samplesToDeadline, this block included. True once all of it is
+    bool continueCopyFrom(const ChorusEchoStage& other, int numSamples, int samplesToDeadline) noexcept {
+        jassert(other.channels.size() == channels.size());
+
+        // The tap moves one sample further into the history per sample.
+        // other overwrites the history just as fast but behind the tap, as
+        // long as this runs before other processes the block
+        echoCopyDue += numSamples;
+
+        auto numToCopy = echoCopyRemaining;
+
+        if (samplesToDeadline > numSamples)
+            numToCopy = (int) (((juce::int64) echoCopyRemaining * numSamples + samplesToDeadline - 1) / samplesToDeadline);
+
+        numToCopy = juce::jlimit(0, echoCopyRemaining, juce::jmax(numToCopy, echoCopyDue));
+
+        for (size_t i = 0; i < channels.size(); ++i)
+            channels[i].echo.copyRangeFrom(other.channels[i].echo, echoCopyStart, numToCopy);
+
+        echoCopyStart += numToCopy;
+        echoCopyRemaining -= numToCopy;
+        echoCopyDue -= numToCopy;
+
+        return echoCopyRemaining == 0;
+    }
+
+    template <typename ProcessContext>
+    void process(const ProcessContext& context) noexcept {
+        auto numSamples = context.getOutputBlock().getNumSamples();
+        jassert(numSamples <= modulation.size());
+
+        // Both off and faded out: the input only goes into the buffers, so
+        // either can be switched on with a full history. The echo's allpass
+        // and lowpass keep following the tap, or they would start from
+        // whatever they held when it faded out
+        if (chorusLevel + chorusTarget + echoLevel + echoTarget == NumericType(0)) {
+            lfoPhase = std::fmod(lfoPhase + lfoIncrement * (double) numSamples, juce::MathConstants<double>::twoPi);
+
+            processChannels(context, [this](size_t channel, const SampleType* input, SampleType* output, size_t n) {
+                auto& state = channels[channel];
+
+                for (size_t i = 0; i < n; ++i) {
+                    auto tap = state.echo.read(echoWhole);
+                    auto delayed = echoAllpass * (tap - state.allpassOut) + state.allpassIn;
+                    state.allpassIn = tap;
+                    state.allpassOut = delayed;
+                    state.lowpass = state.lowpass + damping * (delayed - state.lowpass);
+
+                    state.chorus.push(input[i]);
+                    state.echo.push(input[i]);
+                    output[i] = input[i];
+                }
+            });
+
+            return;
+        }
+
+        prepareBlock(numSamples);
+
+        processChannels(context, [this](size_t channel, const SampleType* input, SampleType* output, size_t n) {
+            auto& state = channels[channel];
+
+            for (size_t i = 0; i < n; ++i) {
+                auto x = input[i];
+
+                // Chorus
+                state.chorus.push(x);
+
+                auto whole = static_cast<int>(modulation[i]);
+                auto wet = Interpolation::read(state.chorus, whole, modulation[i] - static_cast<NumericType>(whole));
+                auto y = x + laneSign * (wet * chorusGain[i]);
+
+                // Echo
+                auto tap = state.echo.read(echoWhole);
+                auto delayed = echoAllpass * (tap - state.allpassOut) + state.allpassIn;
+                state.allpassIn = tap;
+                state.allpassOut = delayed;
+
+                state.lowpass = state.lowpass + damping * (delayed - state.lowpass);
+                auto repeat = state.lowpass * echoGain[i];
+
+                state.echo.push(y + repeat * NumericType(echoFeedback));
+                output[i] = y + repeat * NumericType(echoMix);
+            }
+        });
+    }
+
+private:
+    // Chorus delay centre and sweep, LFO rate
+    static constexpr double chorusCentreTime = 9.0, chorusDepthTime = 3.0, chorusRate = 0.6;
+    static constexpr double chorusWetGain = 0.7;
+
+    // Echo time, feedback, level of the repeats, lowpass on the repeats
+    static constexpr double echoTime = 320.0, echoFeedback = 0.4, echoMix = 0.5, echoDamping = 3000.0;
+
+    // On/off fades
+    static constexpr double rampTime = 10.0;
+
+    struct ChannelState {
+        DelayBuffer<SampleType> chorus, echo;
+        SampleType allpassIn {}, allpassOut {}, lowpass {};
+    };
+
+    // The LFO and the ramps for numSamples, one value per sample shared by
+    // every lane
+    void prepareBlock(size_t numSamples) noexcept {
+        auto sine = std::sin(lfoPhase), cosine = std::cos(lfoPhase);
+        const auto rotateSine = std::sin(lfoIncrement), rotateCosine = std::cos(lfoIncrement);
+
+        for (size_t i = 0; i < numSamples; ++i) {
+            modulation[i] = chorusCentre + chorusDepth * static_cast<NumericType>(sine);
+
+            auto nextSine = sine * rotateCosine + cosine * rotateSine;
+            cosine = cosine * rotateCosine - sine * rotateSine;
+            sine = nextSine;
+
+            chorusLevel += juce::jlimit(-rampStep, rampStep, chorusTarget - chorusLevel);
+            echoLevel += juce::jlimit(-rampStep, rampStep, echoTarget - echoLevel);
+
+            chorusGain[i] = chorusLevel * NumericType(chorusWetGain);
+            echoGain[i] = echoLevel;
+        }
+
+        lfoPhase = std::fmod(lfoPhase + lfoIncrement * (double) numSamples, juce::MathConstants<double>::twoPi);
+    }
+
+    double sampleRate {44100.0};
+
+    NumericType chorusCentre {0}, chorusDepth {0};
+    double lfoIncrement {0.0}, lfoPhase {0.0};
+
+    int echoWhole {1};
+    SampleType echoAllpass {}, damping {};
+
+    // Where continueCopyFrom is in the echo history, how much of it is left
+    // and how far the tap has got ahead of the copy
+    int echoCopyStart {0}, echoCopyRemaining {0}, echoCopyDue {0};
+
+    NumericType chorusTarget {0}, echoTarget {0}, chorusLevel {0}, echoLevel {0}, rampStep {1};
+    SampleType laneSign {getStereoSigns()};
+
+    // 1 on even lanes, -1 on odd ones
+    static SampleType getStereoSigns() noexcept {
+        using Traits = SampleTraits<SampleType>;
+        auto signs = Traits::broadcast(NumericType(1));
+
+        for (size_t lane = 1; lane < Traits::numLanes; lane += 2)
+            Traits::setLane(signs, lane, NumericType(-1));
+
+        return signs;
+    }
+
+    std::vector<ChannelState> channels;
+    std::vector<NumericType> modulation, chorusGain, echoGain;
+};
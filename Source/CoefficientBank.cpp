@@ -0,0 +1,327 @@
+/*
+  ==============================================================================
+
+    CoefficientBank.cpp
+
+  ==============================================================================
+*/
+
+#include "CoefficientBank.h"
+
+namespace {
+
+// What the designs need from <cmath>, which is not constexpr before C++26.
+// Double precision throughout, like the tables
+namespace ConstexprMath {
+    constexpr double pi = juce::MathConstants<double>::pi;
+
+    // Taylor series around 0, the arguments are within +-pi
+    constexpr double sin(double x) {
+        double term = x, sum = x;
+
+        for (int n = 1; n < 14; ++n) {
+            term *= -x * x / (double) ((2 * n) * (2 * n + 1));
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    constexpr double cos(double x) {
+        double term = 1.0, sum = 1.0;
+
+        for (int n = 1; n < 14; ++n) {
+            term *= -x * x / (double) ((2 * n - 1) * (2 * n));
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    constexpr double tan(double x) { return sin(x) / cos(x); }
+
+    constexpr double sqrt(double x) {
+        if (x <= 0.0)
+            return 0.0;
+
+        // Newton from above converges monotonically
+        double root = x > 1.0 ? x : 1.0;
+
+        for (int i = 0; i < 100; ++i) {
+            auto next = 0.5 * (root + x / root);
+
+            if (next >= root)
+                break;
+
+            root = next;
+        }
+
+        return root;
+    }
+
+    // Halved into the range of a short series, then squared back up
+    constexpr double exp(double x) {
+        int halvings = 0;
+
+        while (x > 0.5 || x < -0.5) {
+            x *= 0.5;
+            ++halvings;
+        }
+
+        double term = 1.0, sum = 1.0;
+
+        for (int n = 1; n < 16; ++n) {
+            term *= x / (double) n;
+            sum += term;
+        }
+
+        while (halvings-- > 0)
+            sum *= sum;
+
+        return sum;
+    }
+
+    constexpr double exp2(double x) { return exp(x * 0.69314718055994530942); }
+    constexpr double decibelsToGain(double decibels) { return exp(decibels * 0.11512925464970228420); }
+}
+
+// The formulas of juce::dsp::IIR::Coefficients and FilterDesign, normalised
+// to a0 = 1
+namespace Design {
+    using Biquad = CoefficientBank::Biquad;
+
+    constexpr Biquad normalise(double b0, double b1, double b2, double a0, double a1, double a2) {
+        return {b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0};
+    }
+
+    constexpr Biquad firstOrderHighPass(double sampleRate, double frequency) {
+        auto n = ConstexprMath::tan(ConstexprMath::pi * frequency / sampleRate);
+        return normalise(1.0, -1.0, 0.0, n + 1.0, n - 1.0, 0.0);
+    }
+
+    constexpr Biquad firstOrderLowPass(double sampleRate, double frequency) {
+        auto n = ConstexprMath::tan(ConstexprMath::pi * frequency / sampleRate);
+        return normalise(n, n, 0.0, n + 1.0, n - 1.0, 0.0);
+    }
+
+    constexpr Biquad lowPass(double sampleRate, double frequency, double q) {
+        auto n = 1.0 / ConstexprMath::tan(ConstexprMath::pi * frequency / sampleRate);
+        auto nSquared = n * n;
+        auto c1 = 1.0 / (1.0 + n / q + nSquared);
+        return normalise(c1, c1 * 2.0, c1, 1.0, c1 * 2.0 * (1.0 - nSquared), c1 * (1.0 - n / q + nSquared));
+    }
+
+    constexpr Biquad shelf(double sampleRate, double frequency, double q, double gainFactor, bool high) {
+        auto A = ConstexprMath::sqrt(gainFactor);
+        auto aminus1 = A - 1.0, aplus1 = A + 1.0;
+        auto omega = 2.0 * ConstexprMath::pi * frequency / sampleRate;
+        auto coso = ConstexprMath::cos(omega);
+        auto beta = ConstexprMath::sin(omega) * ConstexprMath::sqrt(A) / q;
+        auto aminus1TimesCoso = aminus1 * coso;
+
+        if (high)
+            return normalise(A * (aplus1 + aminus1TimesCoso + beta), A * -2.0 * (aminus1 + aplus1 * coso), A * (aplus1 + aminus1TimesCoso - beta),
+                             aplus1 - aminus1TimesCoso + beta, 2.0 * (aminus1 - aplus1 * coso), aplus1 - aminus1TimesCoso - beta);
+
+        return normalise(A * (aplus1 - aminus1TimesCoso + beta), A * 2.0 * (aminus1 - aplus1 * coso), A * (aplus1 - aminus1TimesCoso - beta),
+                         aplus1 + aminus1TimesCoso + beta, -2.0 * (aminus1 + aplus1 * coso), aplus1 + aminus1TimesCoso - beta);
+    }
+
+    constexpr Biquad peak(double sampleRate, double frequency, double q, double gainFactor) {
+        auto A = ConstexprMath::sqrt(gainFactor);
+        auto omega = 2.0 * ConstexprMath::pi * frequency / sampleRate;
+        auto alpha = ConstexprMath::sin(omega) / (q * 2.0);
+        auto c2 = -2.0 * ConstexprMath::cos(omega);
+        return normalise(1.0 + alpha * A, c2, 1.0 - alpha * A, 1.0 + alpha / A, c2, 1.0 - alpha / A);
+    }
+
+    // Second-order Butterworth, the one section of designIIRLowpassHighOrderButterworthMethod
+    constexpr Biquad butterworthLowPass(double sampleRate, double frequency) {
+        return lowPass(sampleRate, frequency, 1.0 / (2.0 * ConstexprMath::cos(ConstexprMath::pi / 4.0)));
+    }
+
+    // Copy of section with the numerator scaled by gain
+    constexpr Biquad withGain(Biquad section, double gain) {
+        for (size_t i = 0; i < 3; ++i)
+            section[i] *= gain;
+
+        return section;
+    }
+
+    // The bilinear transform of an analog section with its frequency
+    // warping undone at prewarp:
+    // (b0 + b1 s + b2 s^2) / (a0 + a1 s + a2 s^2)
+    constexpr Biquad bilinear(double sampleRate, double prewarp, double b0, double b1, double b2, double a0, double a1, double a2) {
+        auto omega = 2.0 * ConstexprMath::pi * prewarp;
+        auto k = omega / ConstexprMath::tan(omega / (2.0 * sampleRate));
+        auto k2 = k * k;
+        return normalise(b0 + b1 * k + b2 * k2, 2.0 * (b0 - b2 * k2), b0 - b1 * k + b2 * k2,
+                         a0 + a1 * k + a2 * k2, 2.0 * (a0 - a2 * k2), a0 - a1 * k + a2 * k2);
+    }
+
+    // (b0 + b1 s) / (a0 + a1 s)
+    constexpr Biquad bilinear(double sampleRate, double prewarp, double b0, double b1, double a0, double a1) {
+        auto omega = 2.0 * ConstexprMath::pi * prewarp;
+        auto k = omega / ConstexprMath::tan(omega / (2.0 * sampleRate));
+        return normalise(b0 + b1 * k, b0 - b1 * k, 0.0, a0 + a1 * k, a0 - a1 * k, 0.0);
+    }
+
+    // The two first-order sections multiplied out into one second-order one:
+    // (b0 + b1 z^-1) (c0 + c1 z^-1) / ((1 + a1 z^-1) (1 + d1 z^-1))
+    constexpr Biquad combine(const Biquad& b, const Biquad& c) {
+        return {b[0] * c[0], b[0] * c[1] + b[1] * c[0], b[1] * c[1], b[3] + c[3], b[3] * c[3]};
+    }
+}
+
+// The X100's EQ 1, the network SW101 sends the distortion amp through
+// (Rev 10 schematic, IC103B, IC103A and IC104A), as designed. Every stage
+// is an ideal op-amp, so each one's transfer function follows from its
+// components directly
+namespace X100 {
+    constexpr double R116 = 82.0e3, R117 = 8.2e3, R118 = 100.0e3, R119 = 100.0e3, R120 = 100.0e3, R121 = 47.0e3,
+                     R122 = 100.0e3, R123 = 100.0e3, R125 = 13.0e3, R126 = 13.0e3, R127 = 3.9e3;
+
+    constexpr double C110 = 0.033e-6, C111 = 0.001e-6, C112 = 0.012e-6, C113 = 82.0e-12, C114 = 2700.0e-12,
+                     C115 = 0.047e-6, C116 = 0.001e-6;
+
+    // Below every corner: the two inverting stages and IC103B's bridged T
+    // at their resistor ratios, halved by R128 and R129 mixing in EQ 2
+    constexpr double dcGain = 0.5 * (1.0 + (R119 + R120) / R118) * (R122 + R123) / R121 * R126 / R125;
+
+    // The capacitors divided by factor move every corner up by it, which is
+    // what the Tone control does to the other designs
+    constexpr std::array<CoefficientBank::Biquad, 4> eq1(double sampleRate, double factor) {
+        auto c110 = C110 / factor, c111 = C111 / factor, c112 = C112 / factor, c113 = C113 / factor,
+             c114 = C114 / factor, c115 = C115 / factor, c116 = C116 / factor;
+        auto twoPi = 2.0 * ConstexprMath::pi;
+
+        // R116 into R117 and C110 to ground, at the input of IC103B
+        auto shelf = Design::bilinear(sampleRate, 1.0 / (twoPi * R117 * c110), 1.0, R117 * c110, 1.0, (R116 + R117) * c110);
+
+        // IC103B's gain, 1 + Z / R118 with Z the bridged T of R119, R120,
+        // C112 to ground and C111 across
+        auto g = 1.0 / R118, g1 = 1.0 / R119, g2 = 1.0 / R120;
+        auto bridgedT = Design::bilinear(sampleRate, ConstexprMath::sqrt(g1 * g2 / (c111 * c112)) / twoPi,
+                                         g * (g1 + g2) + g1 * g2, (g + g1) * c112 + c111 * (g1 + g2), c111 * c112,
+                                         g1 * g2, c111 * (g1 + g2), c111 * c112);
+
+        // IC103A, inverting from R121 with the T of R122, R123 and C114 in
+        // the feedback and C113 across it
+        auto gIn = 1.0 / R121, g3 = 1.0 / R122, g4 = 1.0 / R123;
+        auto presence = Design::bilinear(sampleRate, ConstexprMath::sqrt(g3 * g4 / (c113 * c114)) / twoPi,
+                                         -gIn * (g3 + g4), -gIn * c114, 0.0,
+                                         g3 * g4, c113 * (g3 + g4), c113 * c114);
+
+        // IC104A, a multiple feedback low pass
+        auto g5 = 1.0 / R125, g6 = 1.0 / R126, g7 = 1.0 / R127;
+        auto lowPass = Design::bilinear(sampleRate, ConstexprMath::sqrt(g6 * g7 / (c115 * c116)) / twoPi,
+                                        -g5 * g7, 0.0, 0.0,
+                                        g6 * g7, c116 * (g5 + g6 + g7), c115 * c116);
+
+        return {Design::withGain(shelf, 0.5), bridgedT, presence, lowPass};
+    }
+}
+
+}
+
+constexpr CoefficientBank::Tables CoefficientBank::design(double sampleRate) {
+    Tables tables {};
+
+    // MBPF and the CF low shelf, see below
+    tables[Dist].opampSection = 0;
+    tables[Edge].opampSection = 1;
+    tables[Dist].opamp2Section = tables[Edge].opamp2Section = 0;
+
+    tables[Dist].numEQ1 = 1;
+    tables[Edge].numEQ1 = 2;
+    tables[Cln1].numEQ1 = 4;
+    tables[Cln2].numEQ1 = 2;
+    tables[Dist].numEQ2 = tables[Edge].numEQ2 = 3;
+    tables[Dist].numCircuitEQ2 = tables[Edge].numCircuitEQ2 = 4;
+
+    auto opampGain = ConstexprMath::decibelsToGain(opampGainDecibels);
+
+    for (size_t point = 0; point < (size_t) tableSize; ++point) {
+        // -shiftRange ... +shiftRange octaves, HPF and Tone share the points
+        auto factor = ConstexprMath::exp2(shiftRange * (2.0 * (double) point / (tableSize - 1) - 1.0));
+
+        // Shifted up, a corner could end up past Nyquist
+        auto shifted = [&](double frequency) { return juce::jmin(frequency * factor, sampleRate * 0.45); };
+
+        // Designs shared by every mode
+        // HPF 12.A & 13
+        auto hbeq = Design::shelf(sampleRate, shifted(4000.0), 1.30, 4.0, true);
+
+        // MBPF 14
+        auto mbpfHP = Design::firstOrderHighPass(sampleRate, shifted(800.0));
+        auto mbpfLP = Design::firstOrderLowPass(sampleRate, shifted(5000.0));
+
+        // LBEQ 15
+        auto lbeq = Design::shelf(sampleRate, shifted(50.0), 0.6, 4.8, false);
+
+        // CF 17
+        auto cfLS = Design::shelf(sampleRate, shifted(80.0), 1.0, 3.5, false);
+        auto cfPeak = Design::peak(sampleRate, shifted(1600.0), 2.80, 0.1);
+        auto cfLP = Design::butterworthLowPass(sampleRate, shifted(4000.0));
+
+        // MBPF 14 is two first-order sections, they fit in one biquad. Only the
+        // driven modes use it, so it always carries OPAMP 16; OPAMP2 16 goes
+        // into the CF low shelf
+        auto drivenMBPF = Design::withGain(Design::combine(mbpfHP, mbpfLP), opampGain);
+        auto drivenCFLS = Design::withGain(cfLS, 1.0 / opampGain);
+
+        // The X100's EQ 1 in place of CF 17, with OPAMP2 16 in its first
+        // section. The network's own gain below its corners, dcGain, only
+        // follows from resistor ratios chosen for the X100's levels, so it is
+        // divided out and OPAMP2 16 sets the level there, as it does for the
+        // other driven stages. The response above that is the circuit's
+        auto circuitEQ = X100::eq1(sampleRate, factor);
+        circuitEQ[0] = Design::withGain(circuitEQ[0], 1.0 / (X100::dcGain * opampGain));
+
+        for (int mode = 0; mode < numModes; ++mode)
+            tables[(size_t) mode].hpf[point] = Design::firstOrderHighPass(sampleRate, shifted(getHPFFrequency(mode)));
+
+        tables[Dist].eq1[point] = {drivenMBPF};
+        tables[Dist].eq2[point] = {drivenCFLS, cfPeak, cfLP};
+
+        tables[Edge].eq1[point] = {hbeq, drivenMBPF};
+        tables[Edge].eq2[point] = {drivenCFLS, cfPeak, cfLP};
+        tables[Dist].circuitEQ2[point] = tables[Edge].circuitEQ2[point] = circuitEQ;
+
+        tables[Cln1].eq1[point] = {hbeq, cfLS, cfPeak, cfLP};
+
+        tables[Cln2].eq1[point] = {hbeq, lbeq};
+    }
+
+    return tables;
+}
+
+const CoefficientBank::Tables* CoefficientBank::findTables(double sampleRate) noexcept {
+    static constexpr Tables tables44100 = design(44100.0), tables48000 = design(48000.0),
+                            tables88200 = design(88200.0), tables96000 = design(96000.0),
+                            tables176400 = design(176400.0), tables192000 = design(192000.0);
+
+    static constexpr std::pair<double, const Tables*> compiled[] = {
+        {44100.0, &tables44100}, {48000.0, &tables48000},
+        {88200.0, &tables88200}, {96000.0, &tables96000},
+        {176400.0, &tables176400}, {192000.0, &tables192000}
+    };
+
+    for (auto& [rate, tables] : compiled)
+        if (rate == sampleRate)
+            return tables;
+
+    return nullptr;
+}
+
+void CoefficientBank::prepare(double sampleRate) {
+    tables = findTables(sampleRate);
+
+    if (tables != nullptr) {
+        designed.reset();
+        return;
+    }
+
+    designed = std::make_unique<Tables>(design(sampleRate));
+    tables = designed.get();
+}
@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    CoefficientBank.h
+
+    Filter designs for every Mode, looked up once per sample rate in
+    prepareToPlay so that the audio thread never designs a filter.
+
+    Every design is fixed, so the tables for 44.1, 48, 88.2, 96, 176.4 and
+    192 kHz are computed by the compiler. Other rates run the same constexpr
+    designer in prepare.
+
+    In the driven modes the OPAMP gains are folded into the filters next to
+    the AD stage: OPAMP 16 into MBPF, OPAMP2 16 into the CF low shelf.
+    Everything in between is linear, so this is exact.
+
+    The filters after Comp, and after DRIVE in the driven modes, are handed
+    out as one list of sections per run, so each run can be processed as a
+    single cascade:
+
+        Dist   EQ1 = MBPF               EQ2 = CF
+        Edge   EQ1 = HBEQ, MBPF         EQ2 = CF
+        Cln1   EQ1 = HBEQ, CF
+        Cln2   EQ1 = HBEQ, LBEQ
+
+    With the Circuit curve the driven modes take their EQ2 from the X100
+    itself instead: the EQ 1 network of the Rev 10 schematic, designed from
+    its component values and mapped by the bilinear transform.
+
+    HPF 11 and the EQ runs are designed over a range of frequency shifts (the
+    HPF and Tone controls). Between two table points the coefficients are
+    interpolated linearly, which keeps every section stable: the stable
+    region of (a1, a2) is a triangle, and so convex.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+class CoefficientBank {
+public:
+    enum Mode {
+        Dist,
+        Edge,
+        Cln1,
+        Cln2,
+        numModes
+    };
+
+    // b0, b1, b2, a1, a2 with a0 = 1, first-order sections have b2 = a2 = 0.
+    // Double, so the double engine gets the low shelves' poles as designed;
+    // the float engine rounds them as it loads them
+    using Biquad = std::array<double, 5>;
+
+    static constexpr int maxSections = 4;
+
+    // Odd, so that a shift of 0 is a designed point and not an interpolation
+    static constexpr int tableSize = 33;
+
+    // HPF and Tone move their filters by up to this many octaves either way
+    static constexpr float shiftRange = 1.0f;
+
+    struct ModeTable {
+        // HPF 11, over the HPF shift range
+        std::array<Biquad, tableSize> hpf;
+
+        // EQ1 and EQ2, [table point][section], over the Tone range
+        std::array<std::array<Biquad, maxSections>, tableSize> eq1, eq2;
+        int numEQ1 {0}, numEQ2 {0};
+
+        // EQ2 for the Circuit curve, none in the clean modes
+        std::array<std::array<Biquad, maxSections>, tableSize> circuitEQ2;
+        int numCircuitEQ2 {0};
+
+        // Sections that carry OPAMP 16 (in EQ1) and OPAMP2 16 (in EQ2, either
+        // one), -1 in the clean modes. Drive scales their numerators
+        int opampSection {-1}, opamp2Section {-1};
+    };
+
+    using Tables = std::array<ModeTable, numModes>;
+
+    // A lookup at the common rates, otherwise allocates and designs. Call it
+    // from prepareToPlay only
+    void prepare(double sampleRate);
+
+    const ModeTable& operator[](int mode) const { return (*tables)[(size_t) juce::jlimit(0, numModes - 1, mode)]; }
+
+    // The compiled-in tables for this rate, nullptr when it has none
+    static const Tables* findTables(double sampleRate) noexcept;
+
+    // Position in a table of a shift in octaves, clamped to the range
+    static float getTablePosition(float octaves) noexcept {
+        auto position = (octaves / shiftRange + 1.0f) * 0.5f * (float) (tableSize - 1);
+        return juce::jlimit(0.0f, (float) (tableSize - 1), position);
+    }
+
+    static Biquad interpolate(const Biquad& a, const Biquad& b, float amount) noexcept {
+        Biquad result;
+
+        for (size_t i = 0; i < result.size(); ++i)
+            result[i] = a[i] + (double) amount * (b[i] - a[i]);
+
+        return result;
+    }
+
+    // Dist and Edge run through MBPF, OPAMP, AD, OPAMP2
+    static constexpr bool isDriven(int mode) { return mode == Dist || mode == Edge; }
+
+    // HPF 11
+    static constexpr double getHPFFrequency(int mode) { return isDriven(mode) ? 10000.0 : 5000.0; }
+
+    // OPAMP 16, OPAMP2 16 is the inverse
+    static constexpr float opampGainDecibels = 43.07f;
+
+private:
+    const Tables* tables = findTables(44100.0);
+
+    // Only for rates without compiled-in tables
+    std::unique_ptr<Tables> designed;
+
+    // Every mode at every table point, also evaluated by the compiler
+    static constexpr Tables design(double sampleRate);
+};
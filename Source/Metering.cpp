@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    Metering.cpp
+
+  ==============================================================================
+*/
+
+#include "Metering.h"
+
+MeterSource::MeterSource() {
+    spectrum.resize((size_t) fifo.getTotalSize());
+}
+
+void MeterSource::prepare(double sampleRate) noexcept {
+    // 88.2/96 kHz average pairs, 176.4/192 kHz groups of four
+    decimation = juce::jmax(1, (int) (sampleRate / 44100.0));
+    decimationPosition = 0;
+    decimationSum = 0.0f;
+
+    spectrumSampleRate.store(sampleRate / decimation, std::memory_order_relaxed);
+}
+
+template <typename FloatType>
+void MeterSource::storePeaks(Peaks& peaks, const juce::AudioBuffer<FloatType>& buffer) noexcept {
+    auto numChannels = juce::jmin(buffer.getNumChannels(), maximumNumChannels);
+
+    // A peak the reader clears between the load and the store is lost, one
+    // block of one meter, which is not worth a compare-exchange loop
+    for (int channel = 0; channel < numChannels; ++channel) {
+        auto peak = (float) buffer.getMagnitude(channel, 0, buffer.getNumSamples());
+        auto& stored = peaks[(size_t) channel];
+
+        if (peak > stored.load(std::memory_order_relaxed))
+            stored.store(peak, std::memory_order_relaxed);
+    }
+}
+
+float MeterSource::takePeak(Peaks& peaks, int channel) noexcept {
+    if (! juce::isPositiveAndBelow(channel, maximumNumChannels))
+        return 0.0f;
+
+    return peaks[(size_t) channel].exchange(0.0f, std::memory_order_relaxed);
+}
+
+template <typename FloatType>
+void MeterSource::pushInput(const juce::AudioBuffer<FloatType>& buffer) noexcept {
+    storePeaks(inputPeaks, buffer);
+}
+
+template <typename FloatType>
+void MeterSource::pushOutput(const juce::AudioBuffer<FloatType>& buffer) noexcept {
+    storePeaks(outputPeaks, buffer);
+
+    auto numChannels = juce::jmin(buffer.getNumChannels(), maximumNumChannels);
+    auto numSamples = buffer.getNumSamples();
+
+    if (! spectrumEnabled.load(std::memory_order_relaxed) || numChannels == 0)
+        return;
+
+    // The editor is behind, this block is dropped rather than waited for
+    auto numDecimated = (decimationPosition + numSamples) / decimation;
+
+    if (fifo.getFreeSpace() < numDecimated)
+        return;
+
+    std::array<const FloatType*, (size_t) maximumNumChannels> channels {};
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        channels[(size_t) channel] = buffer.getReadPointer(channel);
+
+    auto scale = 1.0f / (float) (numChannels * decimation);
+    auto sample = 0;
+
+    auto accumulate = [&] {
+        for (int channel = 0; channel < numChannels; ++channel)
+            decimationSum += (float) channels[(size_t) channel][sample];
+
+        ++sample;
+        ++decimationPosition;
+    };
+
+    const auto scope = fifo.write(numDecimated);
+
+    scope.forEach([&](int index) {
+        while (decimationPosition < decimation)
+            accumulate();
+
+        spectrum[(size_t) index] = decimationSum * scale;
+        decimationSum = 0.0f;
+        decimationPosition = 0;
+    });
+
+    // Whatever is left starts the next average
+    while (sample < numSamples)
+        accumulate();
+}
+
+template void MeterSource::pushInput(const juce::AudioBuffer<float>&) noexcept;
+template void MeterSource::pushInput(const juce::AudioBuffer<double>&) noexcept;
+template void MeterSource::pushOutput(const juce::AudioBuffer<float>&) noexcept;
+template void MeterSource::pushOutput(const juce::AudioBuffer<double>&) noexcept;
+
+int MeterSource::readSpectrum(float* destination, int maximumSamples) noexcept {
+    const auto scope = fifo.read(maximumSamples);
+    auto numRead = 0;
+
+    scope.forEach([&](int index) {
+        destination[numRead++] = spectrum[(size_t) index];
+    });
+
+    return numRead;
+}
+
+//==============================================================================
+SpectrumAnalyser::SpectrumAnalyser() {
+    history.resize((size_t) fftSize);
+    fftData.resize((size_t) fftSize * 2);
+    levels.resize((size_t) numBins, floorDecibels);
+}
+
+bool SpectrumAnalyser::update(MeterSource& source) {
+    sampleRate = source.getSpectrumSampleRate();
+
+    std::array<float, 512> block;
+    auto numReceived = 0;
+
+    for (;;) {
+        auto numRead = source.readSpectrum(block.data(), (int) block.size());
+
+        if (numRead == 0)
+            break;
+
+        for (int i = 0; i < numRead; ++i) {
+            history[(size_t) historyPosition] = block[(size_t) i];
+            historyPosition = (historyPosition + 1) % fftSize;
+        }
+
+        numReceived += numRead;
+    }
+
+    if (numReceived == 0)
+        return false;
+
+    // Oldest sample first
+    std::fill(fftData.begin(), fftData.end(), 0.0f);
+    std::copy(history.begin() + historyPosition, history.end(), fftData.begin());
+    std::copy(history.begin(), history.begin() + historyPosition, fftData.begin() + (fftSize - historyPosition));
+
+    window.multiplyWithWindowingTable(fftData.data(), (size_t) fftSize);
+    fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+    // A full scale sine comes out at fftSize / 4 through the Hann window
+    const auto scale = 4.0f / (float) fftSize;
+
+    for (size_t bin = 0; bin < levels.size(); ++bin) {
+        auto level = juce::Decibels::gainToDecibels(fftData[bin] * scale, floorDecibels);
+        levels[bin] = juce::jmax(level, levels[bin] - fallDecibels);
+    }
+
+    return true;
+}
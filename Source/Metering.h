@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    Metering.h
+
+    What the editor shows, handed over from the audio thread without locks.
+    Peaks are atomics the editor collects and clears at its own frame rate.
+    The spectrum input is a mono mix, averaged down to a base rate at 88.2 kHz
+    and above, and pushed into a wait-free FIFO that SpectrumAnalyser drains
+    on the message thread. The FFT never runs on the audio thread, and with
+    no editor open the spectrum is not fed at all.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "RokmanEngine.h"
+
+class MeterSource {
+public:
+    static constexpr int maximumNumChannels = RokmanEngine::getMaximumNumChannels();
+
+    MeterSource();
+
+    // Only picks the decimation, the FIFO is allocated once up front so a
+    // reader on another thread never sees it move
+    void prepare(double sampleRate) noexcept;
+
+    // Audio thread, wait-free. pushInput goes before the engine, pushOutput
+    // after it. Float and double buffers
+    template <typename FloatType>
+    void pushInput(const juce::AudioBuffer<FloatType>& buffer) noexcept;
+
+    template <typename FloatType>
+    void pushOutput(const juce::AudioBuffer<FloatType>& buffer) noexcept;
+
+    // Any thread. Highest magnitude since the last call, which clears it
+    float takeInputPeak(int channel) noexcept { return takePeak(inputPeaks, channel); }
+    float takeOutputPeak(int channel) noexcept { return takePeak(outputPeaks, channel); }
+
+    // The editor switches the spectrum on while it is open
+    void setSpectrumEnabled(bool shouldBeEnabled) noexcept { spectrumEnabled.store(shouldBeEnabled, std::memory_order_relaxed); }
+
+    // One reader only. Copies up to maximumSamples of spectrum input, returns
+    // how many it copied
+    int readSpectrum(float* destination, int maximumSamples) noexcept;
+
+    // Rate of the spectrum input after the decimation
+    double getSpectrumSampleRate() const noexcept { return spectrumSampleRate.load(std::memory_order_relaxed); }
+
+private:
+    using Peaks = std::array<std::atomic<float>, (size_t) maximumNumChannels>;
+
+    template <typename FloatType>
+    static void storePeaks(Peaks& peaks, const juce::AudioBuffer<FloatType>& buffer) noexcept;
+    static float takePeak(Peaks& peaks, int channel) noexcept;
+
+    Peaks inputPeaks {}, outputPeaks {};
+
+    // About a second at the base rate, the editor drains it far more often
+    juce::AbstractFifo fifo {1 << 16};
+    std::vector<float> spectrum;
+    std::atomic<bool> spectrumEnabled {false};
+    std::atomic<double> spectrumSampleRate {44100.0};
+
+    // Audio thread only, the average in progress
+    int decimation {1}, decimationPosition {0};
+    float decimationSum {0.0f};
+};
+
+//==============================================================================
+// Message thread side of the spectrum: keeps the newest fftSize samples,
+// transforms them and lets every bin fall slowly, the way a hardware
+// analyser's display does
+class SpectrumAnalyser {
+public:
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2 + 1;
+
+    SpectrumAnalyser();
+
+    // Drains the source and transforms what is newest. Returns false when
+    // nothing arrived, the levels are left as they are then
+    bool update(MeterSource& source);
+
+    // Level of a bin in dB relative to a full scale sine
+    float getLevelDecibels(int bin) const noexcept { return levels[(size_t) bin]; }
+    float getBinFrequency(int bin) const noexcept { return (float) (bin * sampleRate / fftSize); }
+
+    static constexpr float floorDecibels = -100.0f;
+
+private:
+    // dB every bin may fall per update
+    static constexpr float fallDecibels = 1.5f;
+
+    juce::dsp::FFT fft {fftOrder};
+    juce::dsp::WindowingFunction<float> window {(size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false};
+
+    std::vector<float> history, fftData, levels;
+    int historyPosition {0};
+    double sampleRate {44100.0};
+};
@@ -0,0 +1,225 @@
+/*
+  ==============================================================================
+
+    ModeSwitcher.cpp
+
+  ==============================================================================
+*/
+
+#include "ModeSwitcher.h"
+
+template <typename FloatType>
+void BasicModeSwitcher<FloatType>::prepare(double newSampleRate, int maximumBlockSize, int numChannels) {
+    sampleRate = newSampleRate;
+
+    for (auto& engine : engines)
+        engine.prepare(sampleRate, maximumBlockSize, numChannels);
+
+    spareBuffer.setSize(juce::jmax(1, numChannels), juce::jmax(1, maximumBlockSize));
+
+    active = 0;
+    state = State::idle;
+    copyingDelays = false;
+    engines[active].setMode(requestedMode.load(std::memory_order_acquire));
+}
+
+template <typename FloatType>
+void BasicModeSwitcher<FloatType>::reset() {
+    // The output jumps anyway, so a pending switch happens right away
+    engines[active].setMode(requestedMode.load(std::memory_order_acquire));
+    state = State::idle;
+    copyingDelays = false;
+
+    for (auto& engine : engines)
+        engine.reset();
+}
+
+template <typename FloatType>
+void BasicModeSwitcher<FloatType>::setSwitchTimes(double warmUpMilliseconds, double crossfadeMilliseconds) {
+    warmUpTime = juce::jmax(0.0, warmUpMilliseconds);
+    crossfadeTime = juce::jmax(0.0, crossfadeMilliseconds);
+}
+
+template <typename FloatType>
+void BasicModeSwitcher<FloatType>::setChainSettings(const ChainSettings& settings) {
+    setMode(settings.mode);
+    setShaperCurve(settings.clipper);
+    setAntialiasing(settings.antialiasing);
+    setChorusEcho(settings.chorus, settings.echo);
+    setControls(settings.drive, settings.output, settings.hpf, settings.tone);
+
+    // Every oversampler is built in prepare, this only picks one
+    setOversampling(settings.oversampling, settings.oversamplingFilter);
+}
+
+template <typename FloatType>
+void BasicModeSwitcher<FloatType>::setSubBlockSize(int numSamples) {
+    for (auto& engine : engines)
+        engine.setSubBlockSize(numSamples);
+}
+
+template <typename FloatType>
+void BasicModeSwitcher<FloatType>::setChorusEcho(bool chorus, bool echo) {
+    for (auto& engine : engines)
+        engine.setChorusEcho(chorus, echo);
+}
+
+template <typename FloatType>
+void BasicModeSwitcher<FloatType>::setStartPosition(juce::int64 numSamples) {
+    for (auto& engine : engines)
+        engine.setStartPosition(numSamples);
+}
+
+template <typename FloatType>
+void BasicModeSwitcher<FloatType>::setControls(float driveDecibels, float outputDecibels, float hpfOctaves, float toneOctaves) {
+    for (auto& engine : engines) {
+        engine.setDrive(driveDecibels);
+        engine.setOutputLevel(outputDecibels);
+        engine.setHPFShift(hpfOctaves);
+        engine.setTone(toneOctaves);
+    }
+}
+
+template <typename FloatType>
+void BasicModeSwitcher<FloatType>::setOversampling(int factorIndex, int filterType) {
+    for (auto& engine : engines)
+        engine.setOversampling(factorIndex, filterType);
+}
+
+template <typename FloatType>
+void BasicModeSwitcher<FloatType>::setShaperCurve(int curve) {
+    for (auto& engine : engines)
+        engine.setShaperCurve(curve);
+}
+
+template <typename FloatType>
+void BasicModeSwitcher<FloatType>::setAntialiasing(int order) {
+    for (auto& engine : engines)
+        engine.setAntialiasing(order);
+}
+
+template <typename FloatType>
+void BasicModeSwitcher<FloatType>::setProfiler(StageProfiler* profiler) {
+    for (auto& engine : engines)
+        engine.setProfiler(profiler);
+}
+
+template <typename FloatType>
+void BasicModeSwitcher<FloatType>::startSwitch(int mode) {
+    // The spare engine is silent, nothing here can be heard. The echo is
+    // longer than the warm-up, so the new engine takes over the repeats
+    // instead of starting from silence. Its history is up to 1 MB, too much
+    // to clear and copy inside one small block, so it comes over during the
+    // warm-up, see processSwitch
+    engines[spare()].setMode(mode);
+    engines[spare()].startDelayStateCopy(engines[active]);
+    copyingDelays = true;
+
+    warmUpSamples = juce::roundToInt(warmUpTime * sampleRate / 1000.0);
+    crossfadeSamples = juce::jmax(1, juce::roundToInt(crossfadeTime * sampleRate / 1000.0));
+
+    state = State::warmingUp;
+    samplesRemaining = warmUpSamples;
+}
+
+template <typename FloatType>
+void BasicModeSwitcher<FloatType>::process(juce::AudioBuffer<FloatType>& buffer) {
+    auto mode = requestedMode.load(std::memory_order_acquire);
+
+    if (state == State::idle) {
+        if (mode != engines[active].getMode())
+            startSwitch(mode);
+    } else if (state == State::warmingUp && mode != engines[spare()].getMode()) {
+        // Nothing of the spare engine has been heard yet, so it can be
+        // dropped or retargeted
+        if (mode == engines[active].getMode())
+            state = State::idle;
+        else
+            startSwitch(mode);
+    }
+
+    if (state == State::idle) {
+        engines[active].process(buffer);
+        publishGainReduction();
+        return;
+    }
+
+    auto numSamples = buffer.getNumSamples();
+    auto chunkSize = spareBuffer.getNumSamples();
+
+    for (int start = 0; start < numSamples; start += chunkSize) {
+        auto blockSize = juce::jmin(chunkSize, numSamples - start);
+
+        if (state == State::idle)
+            engines[active].process(buffer, start, blockSize);
+        else
+            processSwitch(buffer, start, blockSize);
+    }
+
+    publishGainReduction();
+}
+
+template <typename FloatType>
+void BasicModeSwitcher<FloatType>::publishGainReduction() noexcept {
+    for (size_t channel = 0; channel < gainReduction.size(); ++channel)
+        gainReduction[channel].store(engines[active].getGainReductionDecibels((int) channel), std::memory_order_relaxed);
+}
+
+template <typename FloatType>
+void BasicModeSwitcher<FloatType>::processSwitch(juce::AudioBuffer<FloatType>& buffer, int startSample, int numSamples) {
+    auto numChannels = juce::jmin(engines[active].getNumChannels(), buffer.getNumChannels(), spareBuffer.getNumChannels());
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        spareBuffer.copyFrom(channel, 0, buffer, channel, startSample, numSamples);
+
+    // Before either engine moves on, done by the end of the warm-up
+    if (copyingDelays)
+        copyingDelays = ! engines[spare()].copyDelayState(engines[active], numSamples, state == State::warmingUp ? samplesRemaining : 0);
+
+    engines[active].process(buffer, startSample, numSamples);
+    engines[spare()].process(spareBuffer, 0, numSamples);
+
+    // The old engine's output is kept as it is during the warm-up
+    auto position = 0;
+
+    if (state == State::warmingUp) {
+        auto warmUp = juce::jmin(numSamples, samplesRemaining);
+        position += warmUp;
+        samplesRemaining -= warmUp;
+
+        if (samplesRemaining > 0)
+            return;
+
+        state = State::crossfading;
+        samplesRemaining = crossfadeSamples;
+    }
+
+    auto fadeLength = juce::jmin(numSamples - position, samplesRemaining);
+    auto fadeStart = crossfadeSamples - samplesRemaining;
+    auto increment = FloatType(1) / (FloatType) crossfadeSamples;
+
+    for (int channel = 0; channel < numChannels; ++channel) {
+        auto* output = buffer.getWritePointer(channel, startSample);
+        auto* incoming = spareBuffer.getReadPointer(channel);
+
+        for (int i = 0; i < fadeLength; ++i) {
+            auto gain = (FloatType) (fadeStart + i + 1) * increment;
+            auto n = position + i;
+            output[n] += gain * (incoming[n] - output[n]);
+        }
+
+        // The crossfade ended inside this chunk, the rest is the new engine's
+        for (int n = position + fadeLength; n < numSamples; ++n)
+            output[n] = incoming[n];
+    }
+
+    samplesRemaining -= fadeLength;
+
+    if (samplesRemaining == 0) {
+        active = spare();
+        state = State::idle;
+    }
+}
+
+template class BasicModeSwitcher<float>;
+template class BasicModeSwitcher<double>;
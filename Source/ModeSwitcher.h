@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    ModeSwitcher.h
+
+    Two engines, one audible and one spare. A Mode change never touches
+    the audible engine: the spare one is set to the new Mode, reset, takes
+    over the chorus and echo, and is fed the same input silently for a
+    warm-up window so its filters settle, then the output crossfades over to
+    it and the two swap roles. Outside of a switch only the audible engine
+    runs.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "RokmanEngine.h"
+
+template <typename FloatType>
+class BasicModeSwitcher {
+public:
+    // Allocates, call it from prepareToPlay only
+    void prepare(double sampleRate, int maximumBlockSize, int numChannels);
+    void reset();
+
+    // Lock-free, can be called from any thread. The switch starts on the
+    // audio thread at the next process call; a request made during a
+    // crossfade waits for it to finish
+    void setMode(int mode) noexcept {
+        requestedMode.store(juce::jlimit(0, CoefficientBank::numModes - 1, mode), std::memory_order_release);
+    }
+
+    // The Mode that is audible, the old one until a crossfade has finished
+    int getMode() const noexcept { return engines[active].getMode(); }
+    bool isSwitching() const noexcept { return state != State::idle; }
+
+    // Audio thread or before prepare, takes effect from the next switch on
+    void setSwitchTimes(double warmUpMilliseconds, double crossfadeMilliseconds);
+
+    // Real-time safe. Queues the Mode, the rest goes to both engines
+    void setChainSettings(const ChainSettings& settings);
+
+    // Forwarded to both engines. The sub-block size takes effect at the next
+    // prepare
+    void setSubBlockSize(int numSamples);
+    void setChorusEcho(bool chorus, bool echo);
+    void setControls(float driveDecibels, float outputDecibels, float hpfOctaves, float toneOctaves);
+    void setOversampling(int factorIndex, int filterType);
+    void setShaperCurve(int curve);
+    void setAntialiasing(int order);
+    void setProfiler(StageProfiler* profiler);
+    int getLatencySamples() const { return engines[active].getLatencySamples(); }
+
+    // See RokmanEngine, after reset
+    void setStartPosition(juce::int64 numSamples);
+
+    void process(juce::AudioBuffer<FloatType>& buffer);
+
+    int getNumChannels() const { return engines[active].getNumChannels(); }
+
+    // Lock-free, for the editor. Compressor gain reduction in dB during the
+    // last block of the audible engine
+    float getGainReductionDecibels(int channel) const noexcept {
+        return juce::isPositiveAndBelow(channel, Engine::getMaximumNumChannels())
+                 ? gainReduction[(size_t) channel].load(std::memory_order_relaxed) : 0.0f;
+    }
+
+private:
+    enum class State {
+        idle,
+        warmingUp,
+        crossfading
+    };
+
+    using Engine = BasicRokmanEngine<FloatType>;
+
+    std::array<Engine, 2> engines;
+    size_t active {0};
+
+    // Input copy for the spare engine while a switch is running
+    juce::AudioBuffer<FloatType> spareBuffer;
+
+    std::atomic<int> requestedMode {0};
+    State state {State::idle};
+
+    // The spare engine still has echo history to take over
+    bool copyingDelays {false};
+
+    double sampleRate {44100.0};
+    double warmUpTime {50.0};
+    double crossfadeTime {20.0};
+
+    int warmUpSamples {0};
+    int crossfadeSamples {1};
+    int samplesRemaining {0};
+
+    std::array<std::atomic<float>, Engine::getMaximumNumChannels()> gainReduction {};
+
+    size_t spare() const noexcept { return 1 - active; }
+    void publishGainReduction() noexcept;
+
+    void startSwitch(int mode);
+    void processSwitch(juce::AudioBuffer<FloatType>& buffer, int startSample, int numSamples);
+};
+
+using ModeSwitcher = BasicModeSwitcher<float>;
+using ModeSwitcherDouble = BasicModeSwitcher<double>;
+
+extern template class BasicModeSwitcher<float>;
+extern template class BasicModeSwitcher<double>;
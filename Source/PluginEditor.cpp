@@ -9,17 +9,124 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+//==============================================================================
+void LevelMeter::setRange(float newMinimumDecibels, float newMaximumDecibels, bool shouldHangFromTop) {
+    minimumDecibels = newMinimumDecibels;
+    maximumDecibels = newMaximumDecibels;
+    fromTop = shouldHangFromTop;
+    level = minimumDecibels;
+}
+
+void LevelMeter::setLevel(float decibels) {
+    auto next = juce::jmax(juce::jlimit(minimumDecibels, maximumDecibels, decibels), level - fallDecibels);
+
+    if (next != level) {
+        level = next;
+        repaint();
+    }
+}
+
+void LevelMeter::paint(juce::Graphics& g) {
+    auto bounds = getLocalBounds().toFloat();
+    g.setColour(juce::Colours::black);
+    g.fillRect(bounds);
+
+    auto proportion = (level - minimumDecibels) / (maximumDecibels - minimumDecibels);
+
+    if (fromTop) {
+        g.setColour(juce::Colours::orange);
+        g.fillRect(bounds.removeFromTop(bounds.getHeight() * proportion));
+    } else {
+        g.setColour(level > 0.0f ? juce::Colours::red : juce::Colours::limegreen);
+        g.fillRect(bounds.removeFromBottom(bounds.getHeight() * proportion));
+    }
+}
+
+//==============================================================================
+float SpectrumDisplay::frequencyToX(float frequency) const {
+    return (float) getWidth() * std::log(frequency / minimumFrequency) / std::log(maximumFrequency / minimumFrequency);
+}
+
+float SpectrumDisplay::decibelsToY(float decibels) const {
+    return juce::jmap(decibels, minimumDecibels, maximumDecibels, (float) getHeight(), 0.0f);
+}
+
+void SpectrumDisplay::paint(juce::Graphics& g) {
+    g.fillAll(juce::Colours::black);
+
+    g.setColour(juce::Colours::darkgrey);
+
+    for (auto frequency : {100.0f, 1000.0f, 10000.0f})
+        g.drawVerticalLine(juce::roundToInt(frequencyToX(frequency)), 0.0f, (float) getHeight());
+
+    for (auto decibels : {-24.0f, -48.0f, -72.0f})
+        g.drawHorizontalLine(juce::roundToInt(decibelsToY(decibels)), 0.0f, (float) getWidth());
+
+    juce::Path path;
+
+    for (int bin = 1; bin < SpectrumAnalyser::numBins; ++bin) {
+        auto frequency = analyser.getBinFrequency(bin);
+
+        if (frequency < minimumFrequency)
+            continue;
+
+        if (frequency > maximumFrequency)
+            break;
+
+        auto point = juce::Point<float>(frequencyToX(frequency), decibelsToY(juce::jmax(minimumDecibels, analyser.getLevelDecibels(bin))));
+
+        if (path.isEmpty())
+            path.startNewSubPath(point);
+        else
+            path.lineTo(point);
+    }
+
+    g.setColour(juce::Colours::lightblue);
+    g.strokePath(path, juce::PathStrokeType(1.5f));
+}
+
 //==============================================================================
 RokmanAudioProcessorEditor::RokmanAudioProcessorEditor (RokmanAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p)
 {
+    addComboBox(mode, "Mode");
+    addComboBox(clipper, "Clipper");
+    addComboBox(oversampling, "Oversampling");
+    addComboBox(oversamplingFilter, "OversamplingFilter");
+    addComboBox(antialiasing, "Antialiasing");
+
+    addButton(chorus, "Chorus");
+    addButton(echo, "Echo");
+
+    addSlider(drive, "Drive");
+    addSlider(output, "Output");
+    addSlider(hpf, "HPF");
+    addSlider(tone, "Tone");
+
+    addAndMakeVisible(spectrum);
+
+    for (int channel = 0; channel < juce::jmax(1, audioProcessor.getTotalNumOutputChannels()); ++channel) {
+        inputMeters.add(new LevelMeter())->setRange(-60.0f, 6.0f, false);
+        gainReductionMeters.add(new LevelMeter())->setRange(0.0f, 24.0f, true);
+        outputMeters.add(new LevelMeter())->setRange(-60.0f, 6.0f, false);
+    }
+
+    for (auto* meters : {&inputMeters, &gainReductionMeters, &outputMeters})
+        for (auto* meter : *meters)
+            addAndMakeVisible(meter);
+
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setSize (720, 420);
+
+    audioProcessor.getMeters().setSpectrumEnabled(true);
+    startTimerHz(frameRate);
 }
 
 RokmanAudioProcessorEditor::~RokmanAudioProcessorEditor()
 {
+    stopTimer();
+    audioProcessor.getMeters().setSpectrumEnabled(false);
 }
 
 //==============================================================================
@@ -28,13 +135,100 @@ void RokmanAudioProcessorEditor::paint (juce::Graphics& g)
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
 
+    // Captions under the meter groups
     g.setColour (juce::Colours::white);
-    g.setFont (15.0f);
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
+    g.setFont (12.0f);
+
+    for (auto [meters, text] : {std::pair {&inputMeters, "IN"}, std::pair {&gainReductionMeters, "GR"}, std::pair {&outputMeters, "OUT"}}) {
+        auto area = (*meters)[0]->getBounds().getUnion(meters->getLast()->getBounds());
+        g.drawText (text, area.withY(area.getBottom()).withHeight(16), juce::Justification::centred);
+    }
 }
 
 void RokmanAudioProcessorEditor::resized()
 {
-    // This is generally where you'll want to lay out the positions of any
-    // subcomponents in your editor..
+    auto bounds = getLocalBounds().reduced(10);
+    auto labelHeight = 18;
+
+    // Selectors and switches, then the knobs
+    auto selectors = bounds.removeFromTop(labelHeight + 24);
+    selectors.removeFromTop(labelHeight);
+
+    auto selectorWidth = selectors.getWidth() / 7;
+
+    for (auto* component : std::initializer_list<juce::Component*> {&mode, &clipper, &oversampling, &oversamplingFilter, &antialiasing, &chorus, &echo})
+        component->setBounds(selectors.removeFromLeft(selectorWidth).reduced(4, 0));
+
+    bounds.removeFromTop(8);
+
+    auto knobs = bounds.removeFromTop(labelHeight + 90);
+    knobs.removeFromTop(labelHeight);
+
+    auto knobWidth = knobs.getWidth() / 4;
+
+    for (auto* slider : {&drive, &output, &hpf, &tone})
+        slider->setBounds(knobs.removeFromLeft(knobWidth));
+
+    bounds.removeFromTop(10);
+
+    // Meters on the right, captions drawn underneath in paint
+    auto meterArea = bounds.removeFromRight(150);
+    meterArea.removeFromBottom(16);
+    meterArea.removeFromLeft(10);
+
+    auto groupWidth = meterArea.getWidth() / 3;
+
+    for (auto* meters : {&inputMeters, &gainReductionMeters, &outputMeters}) {
+        auto group = meterArea.removeFromLeft(groupWidth).reduced(4, 0);
+        auto meterWidth = group.getWidth() / meters->size();
+
+        for (auto* meter : *meters)
+            meter->setBounds(group.removeFromLeft(meterWidth).reduced(1, 0));
+    }
+
+    spectrum.setBounds(bounds);
+}
+
+void RokmanAudioProcessorEditor::timerCallback() {
+    auto& meters = audioProcessor.getMeters();
+
+    for (int channel = 0; channel < inputMeters.size(); ++channel) {
+        inputMeters[channel]->setLevel(juce::Decibels::gainToDecibels(meters.takeInputPeak(channel), -60.0f));
+        gainReductionMeters[channel]->setLevel(audioProcessor.getGainReductionDecibels(channel));
+        outputMeters[channel]->setLevel(juce::Decibels::gainToDecibels(meters.takeOutputPeak(channel), -60.0f));
+    }
+
+    if (analyser.update(meters))
+        spectrum.repaint();
+}
+
+void RokmanAudioProcessorEditor::addComboBox(juce::ComboBox& comboBox, const juce::String& parameterID) {
+    // The items have to be in place before the attachment selects one
+    if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(audioProcessor.apvts.getParameter(parameterID)))
+        comboBox.addItemList(choice->choices, 1);
+
+    addAndMakeVisible(comboBox);
+    addLabel(comboBox, audioProcessor.apvts.getParameter(parameterID)->getName(32));
+    comboBoxAttachments.add(new juce::AudioProcessorValueTreeState::ComboBoxAttachment(audioProcessor.apvts, parameterID, comboBox));
+}
+
+void RokmanAudioProcessorEditor::addButton(juce::ToggleButton& button, const juce::String& parameterID) {
+    addAndMakeVisible(button);
+    buttonAttachments.add(new juce::AudioProcessorValueTreeState::ButtonAttachment(audioProcessor.apvts, parameterID, button));
+}
+
+void RokmanAudioProcessorEditor::addSlider(juce::Slider& slider, const juce::String& parameterID) {
+    slider.setSliderStyle(juce::Slider::RotaryHorizontalVerticalDrag);
+    slider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 70, 18);
+
+    addAndMakeVisible(slider);
+    addLabel(slider, audioProcessor.apvts.getParameter(parameterID)->getName(32));
+    sliderAttachments.add(new juce::AudioProcessorValueTreeState::SliderAttachment(audioProcessor.apvts, parameterID, slider));
+}
+
+void RokmanAudioProcessorEditor::addLabel(juce::Component& component, const juce::String& text) {
+    auto* label = labels.add(new juce::Label({}, text));
+    label->setJustificationType(juce::Justification::centred);
+    label->attachToComponent(&component, false);
+    addAndMakeVisible(label);
 }
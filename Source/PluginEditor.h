@@ -11,10 +11,46 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 
+//==============================================================================
+// Vertical bar between minimumDecibels and maximumDecibels. Rises at once and
+// falls by fallDecibels per setLevel, gain reduction hangs from the top
+class LevelMeter : public juce::Component {
+public:
+    void setRange(float newMinimumDecibels, float newMaximumDecibels, bool shouldHangFromTop);
+    void setLevel(float decibels);
+
+    void paint(juce::Graphics& g) override;
+
+private:
+    static constexpr float fallDecibels = 1.0f;
+
+    float minimumDecibels {-60.0f}, maximumDecibels {6.0f};
+    float level {-60.0f};
+    bool fromTop {false};
+};
+
+// SpectrumAnalyser's levels on a log frequency scale
+class SpectrumDisplay : public juce::Component {
+public:
+    explicit SpectrumDisplay(const SpectrumAnalyser& analyserToShow) : analyser(analyserToShow) {}
+
+    void paint(juce::Graphics& g) override;
+
+private:
+    static constexpr float minimumFrequency = 20.0f, maximumFrequency = 20000.0f;
+    static constexpr float minimumDecibels = -96.0f, maximumDecibels = 0.0f;
+
+    float frequencyToX(float frequency) const;
+    float decibelsToY(float decibels) const;
+
+    const SpectrumAnalyser& analyser;
+};
+
 //==============================================================================
 /**
 */
-class RokmanAudioProcessorEditor  : public juce::AudioProcessorEditor
+class RokmanAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                    private juce::Timer
 {
 public:
     RokmanAudioProcessorEditor (RokmanAudioProcessor&);
@@ -25,9 +61,33 @@ public:
     void resized() override;
 
 private:
+    // Meters and spectrum are read here, never pushed from the audio thread
+    void timerCallback() override;
+    static constexpr int frameRate = 30;
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     RokmanAudioProcessor& audioProcessor;
 
+    juce::ComboBox mode, clipper, oversampling, oversamplingFilter, antialiasing;
+    juce::ToggleButton chorus {"Chorus"}, echo {"Echo"};
+    juce::Slider drive, output, hpf, tone;
+    juce::OwnedArray<juce::Label> labels;
+
+    juce::OwnedArray<juce::AudioProcessorValueTreeState::ComboBoxAttachment> comboBoxAttachments;
+    juce::OwnedArray<juce::AudioProcessorValueTreeState::ButtonAttachment> buttonAttachments;
+    juce::OwnedArray<juce::AudioProcessorValueTreeState::SliderAttachment> sliderAttachments;
+
+    void addComboBox(juce::ComboBox& comboBox, const juce::String& parameterID);
+    void addButton(juce::ToggleButton& button, const juce::String& parameterID);
+    void addSlider(juce::Slider& slider, const juce::String& parameterID);
+    void addLabel(juce::Component& component, const juce::String& text);
+
+    SpectrumAnalyser analyser;
+    SpectrumDisplay spectrum {analyser};
+
+    // One per output channel, GR is the compressor after HPF 11
+    juce::OwnedArray<LevelMeter> inputMeters, gainReductionMeters, outputMeters;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RokmanAudioProcessorEditor)
 };
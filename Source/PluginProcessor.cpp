@@ -22,10 +22,26 @@ RokmanAudioProcessor::RokmanAudioProcessor()
                        )
 #endif
 {
+    for (auto* parameter : getParameters())
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter))
+            apvts.addParameterListener(withID->paramID, this);
+    
+   #if ROKMAN_PROFILING
+    engine.setProfiler(&profiler);
+    doubleEngine.setProfiler(&profiler);
+    
+    // ROKMAN_PROFILE_CSV=/path/to/file.csv also keeps every measurement
+    auto csvPath = juce::SystemStats::getEnvironmentVariable("ROKMAN_PROFILE_CSV", {});
+    if (juce::File::isAbsolutePath(csvPath))
+        profiler.setCSVFile(juce::File(csvPath));
+   #endif
 }
 
 RokmanAudioProcessor::~RokmanAudioProcessor()
 {
+    for (auto* parameter : getParameters())
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter))
+            apvts.removeParameterListener(withID->paramID, this);
 }
 
 //==============================================================================
@@ -63,281 +79,70 @@ bool RokmanAudioProcessor::isMidiEffect() const
 
 double RokmanAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // DELAY 1's echo decides most of it, the oversampling latency comes on top
+    auto sampleRate = getSampleRate();
+    auto latency = sampleRate > 0.0 ? getLatencySamples() / sampleRate : 0.0;
+
+    return RokmanEngine::getTailLengthSeconds(getChainSettings(apvts)) + latency;
 }
 
 int RokmanAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return presets.getNumPresets();
 }
 
 int RokmanAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return juce::jmax(0, currentProgram);
 }
 
 void RokmanAudioProcessor::setCurrentProgram (int index)
 {
+    if (! juce::isPositiveAndBelow(index, presets.getNumPresets()))
+        return;
+    
+    currentProgram = index;
+    setParameters(presets.getPreset(index).settings, false);
 }
 
 const juce::String RokmanAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return presets.getPreset(index).name;
 }
 
 void RokmanAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    presets.renamePreset(index, newName);
+}
+
+int RokmanAudioProcessor::storeUserPreset(const juce::String& name) {
+    currentProgram = presets.addUserPreset(name, getChainSettings(apvts));
+    updateHostDisplay(juce::AudioProcessorListener::ChangeDetails().withProgramChanged(true));
+    return currentProgram;
 }
 
 //==============================================================================
 void RokmanAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    juce::dsp::ProcessSpec spec;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;
-    spec.sampleRate = sampleRate;
-    leftChannel.prepare(spec);
-    rightChannel.prepare(spec);
-    
-    auto chainSettings = getChainSettings(apvts);
-    
-    // HPF 11
-    auto hpf1Coeff = juce::dsp::IIR::Coefficients<float>::makeFirstOrderHighPass(sampleRate, getFrequency(chainSettings));
-    updateCoefficients(leftChannel.get<ChainPositions::HPF>().coefficients, hpf1Coeff);
-    updateCoefficients(rightChannel.get<ChainPositions::HPF>().coefficients, hpf1Coeff);
-    
-    // Compressor 12
-    updateCompressor(leftChannel.get<ChainPositions::Comp>());
-    updateCompressor(rightChannel.get<ChainPositions::Comp>());
-    
-    // HPF 12.A & 13 Coefficients
-    auto hbeqCoeff = juce::dsp::IIR::Coefficients<float>::makeHighShelf(sampleRate, 4000.0, 1.30, 4.0);
-    updateCoefficients(leftChannel.get<ChainPositions::HBEQ>().coefficients, hbeqCoeff);
-    updateCoefficients(rightChannel.get<ChainPositions::HBEQ>().coefficients, hbeqCoeff);
-    
-    // MBPF 14 Coefficients
-    auto mbpfHPCoeff = juce::dsp::IIR::Coefficients<float>::makeFirstOrderHighPass(sampleRate, 800.0);
-    auto mbpfLPCoeff = juce::dsp::IIR::Coefficients<float>::makeFirstOrderLowPass(sampleRate, 5000.0);
-    
-    auto& leftMBPF = leftChannel.get<ChainPositions::MBPF>();
-    auto& rightMBPF = rightChannel.get<ChainPositions::MBPF>();
-
-    updateMBPF(leftMBPF, mbpfHPCoeff, mbpfLPCoeff);
-    updateMBPF(rightMBPF, mbpfHPCoeff, mbpfLPCoeff);
-    
-    
-    // LBEQ 15 Coefficients
-    auto lbeqCoefficients = juce::dsp::IIR::Coefficients<float>::makeLowShelf(sampleRate, 50, 0.6, 4.8);
-    updateCoefficients(leftChannel.get<ChainPositions::LBEQ>().coefficients, lbeqCoefficients);
-    updateCoefficients(rightChannel.get<ChainPositions::LBEQ>().coefficients, lbeqCoefficients); 
-    
-    // OPAMP 16
-    leftChannel.get<ChainPositions::OPAMP>().setGainDecibels(43.07f);
-    rightChannel.get<ChainPositions::OPAMP>().setGainDecibels(43.07f);
-    
-    // AD 16
-//    leftChannel.get<ChainPositions::AD>().functionToUse = [] (float x) {
-//        return std::tanh(35*x);
-//    };
-//    rightChannel.get<ChainPositions::AD>().functionToUse = [] (float x) {
-//        return std::tanh(35*x);
-//    };
-    leftChannel.get<ChainPositions::AD>().functionToUse = [] (float x) {
-        return juce::jlimit (float (-1.4), float (1.4), 35*x);
-    };
-    rightChannel.get<ChainPositions::AD>().functionToUse = [] (float x) {
-        return juce::jlimit (float (-1.4), float (1.4), 35*x);
-    };
-    
-    // OPAMP2 16
-    leftChannel.get<ChainPositions::OPAMP2>().setGainDecibels(-43.07f);
-    rightChannel.get<ChainPositions::OPAMP2>().setGainDecibels(-43.07f);
-    
-    // CF 17 Coefficients
-    auto cfLSCoeff = juce::dsp::IIR::Coefficients<float>::makeLowShelf(sampleRate, 80, 1, 3.5);
-    auto cfPeakCoeff = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, 1600, 2.80, 0.1);
-    auto cfLPCoeff = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(4000, sampleRate, 2);
-    
-    auto& leftCF = leftChannel.get<ChainPositions::CF>();
-    auto& rightCF = rightChannel.get<ChainPositions::CF>();
+    // A mono bus gets a single active lane, a stereo bus with identical
+    // channels is detected by the engine and oversampled as one
+    // DELAY 1 derives its delay lengths from the sample rate in here
+    auto numChannels = juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
+    withActiveEngine([&](auto& active) { active.prepare(sampleRate, samplesPerBlock, numChannels); });
+    meters.prepare(sampleRate);
+    
+   #if ROKMAN_PROFILING
+    profiler.setContext(juce::PluginHostType().getHostDescription() + juce::String(", ") + juce::String(sampleRate) + " Hz, "
+                        + juce::String(samplesPerBlock) + " samples", sampleRate);
+   #endif
     
-    updateCF(leftCF, cfLSCoeff, cfPeakCoeff, cfLPCoeff);
-    updateCF(rightCF, cfLSCoeff, cfPeakCoeff, cfLPCoeff);
+    appliedParameterVersion = parameterVersion.load();
+    applyChainSettings(getChainSettings(apvts));
+    withActiveEngine([](auto& active) { active.reset(); });
     
-    // DELAY 1
-    leftChannel.get<ChainPositions::DEL1>().setDelay(fortyMS);
-    rightChannel.get<ChainPositions::DEL1>().setDelay(fortyMS);
-    
-    switch (chainSettings.mode) {
-        case 0: // Dist
-            // HPF 11
-            leftChannel.setBypassed<ChainPositions::HPF>(false);
-            rightChannel.setBypassed<ChainPositions::HPF>(false);
-            
-            // Compressor 12
-            leftChannel.setBypassed<ChainPositions::Comp>(false);
-            rightChannel.setBypassed<ChainPositions::Comp>(false);
-            
-            // HPF 12.A
-            leftChannel.setBypassed<ChainPositions::HBEQ>(true);
-            rightChannel.setBypassed<ChainPositions::HBEQ>(true);
-            
-            // MBPF 14
-            leftChannel.setBypassed<ChainPositions::MBPF>(false);
-            rightChannel.setBypassed<ChainPositions::MBPF>(false);
-            
-            // LBEQ 15
-            leftChannel.setBypassed<ChainPositions::LBEQ>(true);
-            rightChannel.setBypassed<ChainPositions::LBEQ>(true);
-            
-            // OPAMP 16
-            leftChannel.setBypassed<ChainPositions::OPAMP>(false);
-            rightChannel.setBypassed<ChainPositions::OPAMP>(false);
-            
-            // AD 16
-            leftChannel.setBypassed<ChainPositions::AD>(false);
-            rightChannel.setBypassed<ChainPositions::AD>(false);
-            
-            // OPAMP 16 - POST
-            leftChannel.setBypassed<ChainPositions::OPAMP2>(false);
-            rightChannel.setBypassed<ChainPositions::OPAMP2>(false);
-            
-            // CF 17
-            leftChannel.setBypassed<ChainPositions::CF>(false);
-            rightChannel.setBypassed<ChainPositions::CF>(false);
-            
-            // DEL1
-            leftChannel.setBypassed<ChainPositions::DEL1>(false);
-            rightChannel.setBypassed<ChainPositions::DEL1>(false);
-            break;
-            
-        case 1: // Edge
-            // HPF 11
-            leftChannel.setBypassed<ChainPositions::HPF>(false);
-            rightChannel.setBypassed<ChainPositions::HPF>(false);
-            
-            // Compressor 12
-            leftChannel.setBypassed<ChainPositions::Comp>(false);
-            rightChannel.setBypassed<ChainPositions::Comp>(false);
-            
-            // HPF 12.A
-            leftChannel.setBypassed<ChainPositions::HBEQ>(false);
-            rightChannel.setBypassed<ChainPositions::HBEQ>(false);
-            
-            // MBPF 14
-            leftChannel.setBypassed<ChainPositions::MBPF>(false);
-            rightChannel.setBypassed<ChainPositions::MBPF>(false);
-            
-            // LBEQ 15
-            leftChannel.setBypassed<ChainPositions::LBEQ>(true);
-            rightChannel.setBypassed<ChainPositions::LBEQ>(true);
-            
-            // OPAMP 16
-            leftChannel.setBypassed<ChainPositions::OPAMP>(false);
-            rightChannel.setBypassed<ChainPositions::OPAMP>(false);
-            
-            // AD 16
-            leftChannel.setBypassed<ChainPositions::AD>(false);
-            rightChannel.setBypassed<ChainPositions::AD>(false);
-            
-            // OPAMP 16 - POST
-            leftChannel.setBypassed<ChainPositions::OPAMP2>(false);
-            rightChannel.setBypassed<ChainPositions::OPAMP2>(false);
-            
-            // CF 17
-            leftChannel.setBypassed<ChainPositions::CF>(false);
-            rightChannel.setBypassed<ChainPositions::CF>(false);
-            
-            // DEL1
-            leftChannel.setBypassed<ChainPositions::DEL1>(false);
-            rightChannel.setBypassed<ChainPositions::DEL1>(false);
-            break;
-            
-        case 2: // Cln1
-            // HPF 11
-            leftChannel.setBypassed<ChainPositions::HPF>(false);
-            rightChannel.setBypassed<ChainPositions::HPF>(false);
-            
-            // Compressor 12
-            leftChannel.setBypassed<ChainPositions::Comp>(false);
-            rightChannel.setBypassed<ChainPositions::Comp>(false);
-            
-            // HPF 12.A
-            leftChannel.setBypassed<ChainPositions::HBEQ>(false);
-            rightChannel.setBypassed<ChainPositions::HBEQ>(false);
-            
-            // MBPF 14
-            leftChannel.setBypassed<ChainPositions::MBPF>(true);
-            rightChannel.setBypassed<ChainPositions::MBPF>(true);
-            
-            // LBEQ 15
-            leftChannel.setBypassed<ChainPositions::LBEQ>(true);
-            rightChannel.setBypassed<ChainPositions::LBEQ>(true);
-            
-            // OPAMP 16
-            leftChannel.setBypassed<ChainPositions::OPAMP>(true);
-            rightChannel.setBypassed<ChainPositions::OPAMP>(true);
-            
-            // AD 16
-            leftChannel.setBypassed<ChainPositions::AD>(true);
-            rightChannel.setBypassed<ChainPositions::AD>(true);
-            
-            // OPAMP 16 - POST
-            leftChannel.setBypassed<ChainPositions::OPAMP2>(true);
-            rightChannel.setBypassed<ChainPositions::OPAMP2>(true);
-            
-            // CF 17
-            leftChannel.setBypassed<ChainPositions::CF>(false);
-            rightChannel.setBypassed<ChainPositions::CF>(false);
-            
-            // DEL1
-            leftChannel.setBypassed<ChainPositions::DEL1>(false);
-            rightChannel.setBypassed<ChainPositions::DEL1>(false);
-            break;
-            
-        case 3: // Cln2
-            // HPF 11
-            leftChannel.setBypassed<ChainPositions::HPF>(false);
-            rightChannel.setBypassed<ChainPositions::HPF>(false);
-            
-            // Compressor 12
-            leftChannel.setBypassed<ChainPositions::Comp>(false);
-            rightChannel.setBypassed<ChainPositions::Comp>(false);
-            
-            // HPF 12.A
-            leftChannel.setBypassed<ChainPositions::HBEQ>(false);
-            rightChannel.setBypassed<ChainPositions::HBEQ>(false);
-            
-            // MBPF 14
-            leftChannel.setBypassed<ChainPositions::MBPF>(true);
-            rightChannel.setBypassed<ChainPositions::MBPF>(true);
-            
-            // LBEQ 15
-            leftChannel.setBypassed<ChainPositions::LBEQ>(false);
-            rightChannel.setBypassed<ChainPositions::LBEQ>(false);
-            
-            // OPAMP 16
-            leftChannel.setBypassed<ChainPositions::OPAMP>(true);
-            rightChannel.setBypassed<ChainPositions::OPAMP>(true);
-            
-            // AD 16
-            leftChannel.setBypassed<ChainPositions::AD>(true);
-            rightChannel.setBypassed<ChainPositions::AD>(true);
-            
-            // OPAMP 16 - POST
-            leftChannel.setBypassed<ChainPositions::OPAMP2>(true);
-            rightChannel.setBypassed<ChainPositions::OPAMP2>(true);
-            
-            // CF 17
-            leftChannel.setBypassed<ChainPositions::CF>(true);
-            rightChannel.setBypassed<ChainPositions::CF>(true);
-            
-            // DEL1
-            leftChannel.setBypassed<ChainPositions::DEL1>(false);
-            rightChannel.setBypassed<ChainPositions::DEL1>(false);
-            break;
-    }
+    // Not on the audio thread here, the host gets it before playback starts
+    cancelPendingUpdate();
+    setLatencySamples(engineLatency.load());
 }
 
 void RokmanAudioProcessor::releaseResources()
@@ -372,9 +177,27 @@ bool RokmanAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) c
 }
 #endif
 
-void RokmanAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+bool RokmanAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+void RokmanAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    process(buffer, engine);
+}
+
+// 64-bit hosts get the double chain, no conversion of the buffer on the way
+// in or out
+void RokmanAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
 {
+    process(buffer, doubleEngine);
+}
+
+template <typename FloatType>
+void RokmanAudioProcessor::process(juce::AudioBuffer<FloatType>& buffer, BasicModeSwitcher<FloatType>& switcher) {
     juce::ScopedNoDenormals noDenormals;
+    ROKMAN_PROFILE_SCOPE(&profiler, processBlockSection, buffer.getNumSamples());
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -387,258 +210,20 @@ void RokmanAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce:
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
     
-    auto chainSettings = getChainSettings(apvts);
-    // Testing github
-    
-    // HPF 11
-    auto hpf1Coeff = juce::dsp::IIR::Coefficients<float>::makeFirstOrderHighPass(getSampleRate(), getFrequency(chainSettings));
-    updateCoefficients(leftChannel.get<ChainPositions::HPF>().coefficients, hpf1Coeff);
-    updateCoefficients(rightChannel.get<ChainPositions::HPF>().coefficients, hpf1Coeff);
-    
-    // Compressor 12
-    updateCompressor(leftChannel.get<ChainPositions::Comp>());
-    updateCompressor(rightChannel.get<ChainPositions::Comp>());
-    
-    // HPF 12.A & 13 Coefficients
-    auto hbeqCoeff = juce::dsp::IIR::Coefficients<float>::makeHighShelf(getSampleRate(), 4000.0, 1.30, 4.0);
-    updateCoefficients(leftChannel.get<ChainPositions::HBEQ>().coefficients, hbeqCoeff);
-    updateCoefficients(rightChannel.get<ChainPositions::HBEQ>().coefficients, hbeqCoeff);
-    
-    // MBPF 14 Coefficients
-    auto mbpfHPCoeff = juce::dsp::IIR::Coefficients<float>::makeFirstOrderHighPass(getSampleRate(), 800.0);
-    auto mbpfLPCoeff = juce::dsp::IIR::Coefficients<float>::makeFirstOrderLowPass(getSampleRate(), 5000.0);
-
-    auto& leftMBPF = leftChannel.get<ChainPositions::MBPF>();
-    auto& rightMBPF = rightChannel.get<ChainPositions::MBPF>();
-
-    updateMBPF(leftMBPF, mbpfHPCoeff, mbpfLPCoeff);
-    updateMBPF(rightMBPF, mbpfHPCoeff, mbpfLPCoeff);
-    
-    // LBEQ 15 Coefficients
-    auto lbeqCoefficients = juce::dsp::IIR::Coefficients<float>::makeLowShelf(getSampleRate(), 50, 0.6, 4.8);
-    updateCoefficients(leftChannel.get<ChainPositions::LBEQ>().coefficients, lbeqCoefficients);
-    updateCoefficients(rightChannel.get<ChainPositions::LBEQ>().coefficients, lbeqCoefficients);
-    
-    // OPAMP 16
-    // 29.63
-    // 3.03
-    // 43.07
-    leftChannel.get<ChainPositions::OPAMP>().setGainDecibels(43.07f);
-    rightChannel.get<ChainPositions::OPAMP>().setGainDecibels(43.07f);
-    
-    // AD 16
-//    leftChannel.get<ChainPositions::AD>().functionToUse = [] (float x) {
-//        return std::tanh(35*x);
-//    };
-//    rightChannel.get<ChainPositions::AD>().functionToUse = [] (float x) {
-//        return std::tanh(35*x);
-//    };
-    leftChannel.get<ChainPositions::AD>().functionToUse = [] (float x) {
-        return juce::jlimit (float (-1.4), float (1.4), 35*x);
-    };
-    rightChannel.get<ChainPositions::AD>().functionToUse = [] (float x) {
-        return juce::jlimit (float (-1.4), float (1.4), 35*x);
-    };
-    
-    // OPAMP2 16
-    leftChannel.get<ChainPositions::OPAMP2>().setGainDecibels(-43.07f);
-    rightChannel.get<ChainPositions::OPAMP2>().setGainDecibels(-43.07f);
-    
-    // CF 17 Coefficients
-    auto cfLSCoeff = juce::dsp::IIR::Coefficients<float>::makeLowShelf(getSampleRate(), 80, 1, 3.5);
-    auto cfPeakCoeff = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), 1600, 2.8, 0.1);
-    auto cfLPCoeff = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(4000, getSampleRate(), 2);
-    
-    auto& leftCF = leftChannel.get<ChainPositions::CF>();
-    auto& rightCF = rightChannel.get<ChainPositions::CF>();
-    
-    updateCF(leftCF, cfLSCoeff, cfPeakCoeff, cfLPCoeff);
-    updateCF(rightCF, cfLSCoeff, cfPeakCoeff, cfLPCoeff);
-    
-    // DELAY 1
-    leftChannel.get<ChainPositions::DEL1>().setDelay(fortyMS);
-    rightChannel.get<ChainPositions::DEL1>().setDelay(fortyMS);
-    
-    switch (chainSettings.mode) {
-        case 0: // Dist
-            // HPF 11
-            leftChannel.setBypassed<ChainPositions::HPF>(false);
-            rightChannel.setBypassed<ChainPositions::HPF>(false);
-            
-            // Compressor 12
-            leftChannel.setBypassed<ChainPositions::Comp>(false);
-            rightChannel.setBypassed<ChainPositions::Comp>(false);
-            
-            // HPF 12.A
-            leftChannel.setBypassed<ChainPositions::HBEQ>(true);
-            rightChannel.setBypassed<ChainPositions::HBEQ>(true);
-            
-            // MBPF 14
-            leftChannel.setBypassed<ChainPositions::MBPF>(false);
-            rightChannel.setBypassed<ChainPositions::MBPF>(false);
-            
-            // LBEQ 15
-            leftChannel.setBypassed<ChainPositions::LBEQ>(true);
-            rightChannel.setBypassed<ChainPositions::LBEQ>(true);
-            
-            // OPAMP 16
-            leftChannel.setBypassed<ChainPositions::OPAMP>(false);
-            rightChannel.setBypassed<ChainPositions::OPAMP>(false);
-            
-            // AD 16
-            leftChannel.setBypassed<ChainPositions::AD>(false);
-            rightChannel.setBypassed<ChainPositions::AD>(false);
-            
-            // OPAMP 16 - POST
-            leftChannel.setBypassed<ChainPositions::OPAMP2>(false);
-            rightChannel.setBypassed<ChainPositions::OPAMP2>(false);
-            
-            // CF 17
-            leftChannel.setBypassed<ChainPositions::CF>(false);
-            rightChannel.setBypassed<ChainPositions::CF>(false);
-            
-            // DELAY 1
-            leftChannel.setBypassed<ChainPositions::DEL1>(false);
-            rightChannel.setBypassed<ChainPositions::DEL1>(false);
-            break;
-            
-        case 1: // Edge
-            // HPF 11
-            leftChannel.setBypassed<ChainPositions::HPF>(false);
-            rightChannel.setBypassed<ChainPositions::HPF>(false);
-            
-            // Compressor 12
-            leftChannel.setBypassed<ChainPositions::Comp>(false);
-            rightChannel.setBypassed<ChainPositions::Comp>(false);
-            
-            // HPF 12.A
-            leftChannel.setBypassed<ChainPositions::HBEQ>(false);
-            rightChannel.setBypassed<ChainPositions::HBEQ>(false);
-            
-            // MBPF 14
-            leftChannel.setBypassed<ChainPositions::MBPF>(false);
-            rightChannel.setBypassed<ChainPositions::MBPF>(false);
-            
-            // LBEQ 15
-            leftChannel.setBypassed<ChainPositions::LBEQ>(true);
-            rightChannel.setBypassed<ChainPositions::LBEQ>(true);
-            
-            // OPAMP 16
-            leftChannel.setBypassed<ChainPositions::OPAMP>(false);
-            rightChannel.setBypassed<ChainPositions::OPAMP>(false);
-            
-            // AD 16
-            leftChannel.setBypassed<ChainPositions::AD>(false);
-            rightChannel.setBypassed<ChainPositions::AD>(false);
-            
-            // OPAMP 16 - POST
-            leftChannel.setBypassed<ChainPositions::OPAMP2>(false);
-            rightChannel.setBypassed<ChainPositions::OPAMP2>(false);
-            
-            // CF 17
-            leftChannel.setBypassed<ChainPositions::CF>(false);
-            rightChannel.setBypassed<ChainPositions::CF>(false);
-            
-            // DELAY 1
-            leftChannel.setBypassed<ChainPositions::DEL1>(false);
-            rightChannel.setBypassed<ChainPositions::DEL1>(false);
-            break;
-            
-        case 2: // Cln1
-            // HPF 11
-            leftChannel.setBypassed<ChainPositions::HPF>(false);
-            rightChannel.setBypassed<ChainPositions::HPF>(false);
-            
-            // Compressor 12
-            leftChannel.setBypassed<ChainPositions::Comp>(false);
-            rightChannel.setBypassed<ChainPositions::Comp>(false);
-            
-            // HPF 12.A
-            leftChannel.setBypassed<ChainPositions::HBEQ>(false);
-            rightChannel.setBypassed<ChainPositions::HBEQ>(false);
-            
-            // MBPF 14
-            leftChannel.setBypassed<ChainPositions::MBPF>(true);
-            rightChannel.setBypassed<ChainPositions::MBPF>(true);
-            
-            // LBEQ 15
-            leftChannel.setBypassed<ChainPositions::LBEQ>(true);
-            rightChannel.setBypassed<ChainPositions::LBEQ>(true);
-            
-            // OPAMP 16
-            leftChannel.setBypassed<ChainPositions::OPAMP>(true);
-            rightChannel.setBypassed<ChainPositions::OPAMP>(true);
-            
-            // AD 16
-            leftChannel.setBypassed<ChainPositions::AD>(true);
-            rightChannel.setBypassed<ChainPositions::AD>(true);
-            
-            // OPAMP 16 - POST
-            leftChannel.setBypassed<ChainPositions::OPAMP2>(true);
-            rightChannel.setBypassed<ChainPositions::OPAMP2>(true);
-            
-            // CF 17
-            leftChannel.setBypassed<ChainPositions::CF>(false);
-            rightChannel.setBypassed<ChainPositions::CF>(false);
-            
-            // DELAY 1
-            leftChannel.setBypassed<ChainPositions::DEL1>(false);
-            rightChannel.setBypassed<ChainPositions::DEL1>(false);
-            break;
-            
-        case 3: // Cln2
-            // HPF 11
-            leftChannel.setBypassed<ChainPositions::HPF>(false);
-            rightChannel.setBypassed<ChainPositions::HPF>(false);
-            
-            // Compressor 12
-            leftChannel.setBypassed<ChainPositions::Comp>(false);
-            rightChannel.setBypassed<ChainPositions::Comp>(false);
-            
-            // HPF 12.A
-            leftChannel.setBypassed<ChainPositions::HBEQ>(false);
-            rightChannel.setBypassed<ChainPositions::HBEQ>(false);
-            
-            // MBPF 14
-            leftChannel.setBypassed<ChainPositions::MBPF>(true);
-            rightChannel.setBypassed<ChainPositions::MBPF>(true);
-            
-            // LBEQ 15
-            leftChannel.setBypassed<ChainPositions::LBEQ>(false);
-            rightChannel.setBypassed<ChainPositions::LBEQ>(false);
-            
-            // OPAMP 16
-            leftChannel.setBypassed<ChainPositions::OPAMP>(true);
-            rightChannel.setBypassed<ChainPositions::OPAMP>(true);
-            
-            // AD 16
-            leftChannel.setBypassed<ChainPositions::AD>(true);
-            rightChannel.setBypassed<ChainPositions::AD>(true);
-            
-            // OPAMP 16 - POST
-            leftChannel.setBypassed<ChainPositions::OPAMP2>(true);
-            rightChannel.setBypassed<ChainPositions::OPAMP2>(true);
-            
-            // CF 17
-            leftChannel.setBypassed<ChainPositions::CF>(true);
-            rightChannel.setBypassed<ChainPositions::CF>(true);
-            
-            // DELAY 1
-            leftChannel.setBypassed<ChainPositions::DEL1>(false);
-            rightChannel.setBypassed<ChainPositions::DEL1>(false);
-            break;
+    // Nothing is redesigned or reassigned unless a parameter actually moved
+    {
+        ROKMAN_PROFILE_SCOPE(&profiler, parametersSection, buffer.getNumSamples());
+        
+        auto version = parameterVersion.load();
+        if (version != appliedParameterVersion) {
+            appliedParameterVersion = version;
+            applyChainSettings(getChainSettings(apvts));
+        }
     }
     
-    juce::dsp::AudioBlock<float> block(buffer);
-    
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
-    
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
-    
-    leftChannel.process(leftContext);
-    rightChannel.process(rightContext);
+    meters.pushInput(buffer);
+    switcher.process(buffer);
+    meters.pushOutput(buffer);
 }
 
 //==============================================================================
@@ -649,45 +234,114 @@ bool RokmanAudioProcessor::hasEditor() const
 
 juce::AudioProcessorEditor* RokmanAudioProcessor::createEditor()
 {
-//    return new RokmanAudioProcessorEditor (*this);
-    return new juce::GenericAudioProcessorEditor(*this);
+    return new RokmanAudioProcessorEditor (*this);
 }
 
 //==============================================================================
 void RokmanAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // PresetBank.h describes the format
+    presets.writeState(destData, getChainSettings(apvts), currentProgram);
 }
 
 void RokmanAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    ChainSettings settings;
+    int program = 0;
+    
+    if (! presets.readState(data, sizeInBytes, settings, program))
+        return;
+    
+    currentProgram = program;
+    setParameters(settings, true);
+    updateHostDisplay(juce::AudioProcessorListener::ChangeDetails().withProgramChanged(true));
 }
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState &apvts) {
+ChainSettings getChainSettings(const juce::AudioProcessorValueTreeState &apvts) {
     ChainSettings settings;
     settings.mode = apvts.getRawParameterValue("Mode")->load();
+    settings.oversampling = apvts.getRawParameterValue("Oversampling")->load();
+    settings.oversamplingFilter = apvts.getRawParameterValue("OversamplingFilter")->load();
+    settings.clipper = apvts.getRawParameterValue("Clipper")->load();
+    settings.antialiasing = apvts.getRawParameterValue("Antialiasing")->load();
+    settings.chorus = apvts.getRawParameterValue("Chorus")->load() > 0.5f;
+    settings.echo = apvts.getRawParameterValue("Echo")->load() > 0.5f;
+    settings.drive = apvts.getRawParameterValue("Drive")->load();
+    settings.output = apvts.getRawParameterValue("Output")->load();
+    settings.hpf = apvts.getRawParameterValue("HPF")->load();
+    settings.tone = apvts.getRawParameterValue("Tone")->load();
     return settings;
 };
 
-float RokmanAudioProcessor::getFrequency(const ChainSettings &chainSettings ) {
-    if (chainSettings.mode == 0 || chainSettings.mode == 1) {
-        return 10000.0;
-    } else {
-        return 5000.0;
-    }
+void RokmanAudioProcessor::parameterChanged(const juce::String &parameterID, float newValue) {
+    juce::ignoreUnused(parameterID, newValue);
+    ++parameterVersion;
 }
 
-void RokmanAudioProcessor::updateCoefficients(Coefficients &old, const Coefficients &replacements) {
-    *old = *replacements;
+void RokmanAudioProcessor::applyChainSettings(const ChainSettings &chainSettings) {
+    withActiveEngine([&](auto& active) {
+        active.setChainSettings(chainSettings);
+        
+        auto latency = active.getLatencySamples();
+        if (engineLatency.exchange(latency) != latency)
+            triggerAsyncUpdate();
+    });
+}
+
+void RokmanAudioProcessor::handleAsyncUpdate() {
+    setLatencySamples(engineLatency.load());
+}
+
+void RokmanAudioProcessor::setParameters(const ChainSettings &chainSettings, bool includeOversampling) {
+    auto set = [this](const juce::String &parameterID, float value) {
+        if (auto* parameter = apvts.getParameter(parameterID))
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    };
+    
+    set("Mode", (float) chainSettings.mode);
+    set("Clipper", (float) chainSettings.clipper);
+    set("Chorus", chainSettings.chorus ? 1.0f : 0.0f);
+    set("Echo", chainSettings.echo ? 1.0f : 0.0f);
+    set("Drive", chainSettings.drive);
+    set("Output", chainSettings.output);
+    set("HPF", chainSettings.hpf);
+    set("Tone", chainSettings.tone);
+    
+    // Can move the latency by a sample, which processBlock passes on to the
+    // host like any other latency change
+    set("Antialiasing", (float) chainSettings.antialiasing);
+    
+    if (includeOversampling) {
+        set("Oversampling", (float) chainSettings.oversampling);
+        set("OversamplingFilter", (float) chainSettings.oversamplingFilter);
+    }
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout RokmanAudioProcessor::createParameterLayout() {
     juce::AudioProcessorValueTreeState::ParameterLayout layout;
     layout.add(std::make_unique<juce::AudioParameterChoice>("Mode", "Mode", juce::StringArray {"Dist", "Edge", "Cln1", "Cln2"}, 0));
+    
+    // AD 16 transfer curve
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Clipper", "Clipper", juce::StringArray {"Hard", "Tanh", "Diode", "Asym", "Circuit"}, 0));
+    
+    // Oversampling of the OPAMP -> AD -> OPAMP2 section only, the filters stay at the base rate
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Oversampling", "Oversampling", juce::StringArray {"1x", "2x", "4x", "8x"}, 0));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("OversamplingFilter", "Oversampling Filter", juce::StringArray {"IIR", "FIR"}, 0));
+    
+    // Antiderivative antialiasing of the Hard and Tanh clippers, much cheaper
+    // than oversampling and can be combined with it
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Antialiasing", "Antialiasing", juce::StringArray {"Off", "ADAA1", "ADAA2"}, 0));
+    
+    // DELAY 1
+    layout.add(std::make_unique<juce::AudioParameterBool>("Chorus", "Chorus", false));
+    layout.add(std::make_unique<juce::AudioParameterBool>("Echo", "Echo", false));
+    
+    // Smoothed in the engine, safe to automate. Drive is added to OPAMP 16 and
+    // taken off again after AD 16, HPF and Tone move HPF 11 and the EQ filters
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Drive", "Drive", juce::NormalisableRange<float>(-12.0f, 12.0f, 0.1f), 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Output", "Output", juce::NormalisableRange<float>(-24.0f, 12.0f, 0.1f), 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("HPF", "HPF", juce::NormalisableRange<float>(-1.0f, 1.0f, 0.01f), 0.0f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Tone", "Tone", juce::NormalisableRange<float>(-1.0f, 1.0f, 0.01f), 0.0f));
     return layout;
 }
 //==============================================================================
@@ -9,17 +9,18 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "ModeSwitcher.h"
+#include "PresetBank.h"
+#include "Metering.h"
 
-struct ChainSettings {
-    int mode {0};
-};
-
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState &apvts);
+ChainSettings getChainSettings(const juce::AudioProcessorValueTreeState &apvts);
 
 //==============================================================================
 /**
 */
-class RokmanAudioProcessor  : public juce::AudioProcessor
+class RokmanAudioProcessor  : public juce::AudioProcessor,
+                              private juce::AudioProcessorValueTreeState::Listener,
+                              private juce::AsyncUpdater
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
@@ -38,6 +39,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -67,65 +70,73 @@ public:
     
     // Es la variable a la que se cuelgan los datos
     juce::AudioProcessorValueTreeState apvts {*this, nullptr, "Parameters", createParameterLayout()};
-private:
-    using Filter = juce::dsp::IIR::Filter<float>;
-    using Compressor = juce::dsp::Compressor<float>;
-    using WaveShaper = juce::dsp::WaveShaper<float>;
-    using Gain = juce::dsp::Gain<float>;
-    using MidBandPassFilter = juce::dsp::ProcessorChain<Filter, Filter>;
-    using ComplexFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter>;
-    using DelayLine = juce::dsp::DelayLine<float>;
-    using MonoChain = juce::dsp::ProcessorChain<Filter, Compressor, Filter, MidBandPassFilter, Gain, WaveShaper, Gain, Filter, ComplexFilter, DelayLine>;
     
-    MonoChain leftChannel, rightChannel;
+    // Saves the current parameters as a new program, returns its index
+    int storeUserPreset(const juce::String& name);
     
-    enum ChainPositions {
-        HPF,
-        Comp,
-        HBEQ,
-        MBPF,
-        OPAMP,
-        AD,
-        OPAMP2,
-        LBEQ,
-        CF,
-        DEL1
-    };
+    // For the editor, both lock-free
+    MeterSource& getMeters() noexcept { return meters; }
+    float getGainReductionDecibels(int channel) const noexcept {
+        return isUsingDoublePrecision() ? doubleEngine.getGainReductionDecibels(channel) : engine.getGainReductionDecibels(channel);
+    }
+private:
+    // Both channels run through one SIMD chain, Mode changes are crossfaded.
+    // The host picks float or double before prepareToPlay, only the engine
+    // for that precision is prepared and run
+    ModeSwitcher engine;
+    ModeSwitcherDouble doubleEngine;
     
-    float getFrequency(const ChainSettings &chainSettings);
+    template <typename Function>
+    void withActiveEngine(Function&& function) {
+        if (isUsingDoublePrecision())
+            function(doubleEngine);
+        else
+            function(engine);
+    }
     
-    using Coefficients = Filter::CoefficientsPtr;
+    // Both processBlocks
+    template <typename FloatType>
+    void process(juce::AudioBuffer<FloatType>& buffer, BasicModeSwitcher<FloatType>& switcher);
     
-    static void updateCoefficients(Coefficients &old, const Coefficients &replacements);
+    // Levels and spectrum input, written around engine.process
+    MeterSource meters;
     
-    template<typename ChainType> void updateMBPF(ChainType& mbpf, Coefficients hpCoeff, Coefficients lpCoeff) {
-        *mbpf.template get<0>().coefficients = *hpCoeff;
-        *mbpf.template get<1>().coefficients = *lpCoeff;
-        mbpf.template setBypassed<0>(false);
-        mbpf.template setBypassed<1>(false);
+    // Profiler sections after the engine's ChainPositions
+    enum {
+        parametersSection = RokmanEngine::numChainPositions,
+        processBlockSection
     };
     
-    template<typename ChainType, typename CoefficientType> void updateCF(ChainType& cf, Coefficients lsCoeff, Coefficients peakCoeff, CoefficientType lpCoeff) {
-        *cf.template get<0>().coefficients = *lsCoeff;
-        *cf.template get<1>().coefficients = *peakCoeff;
-        *cf.template get<2>().coefficients = *lpCoeff[0];
-        cf.template setBypassed<0>(false);
-        cf.template setBypassed<1>(false);
-        cf.template setBypassed<2>(false);
-    };
+   #if ROKMAN_PROFILING
+    StageProfiler profiler {{"HPF", "Comp", "EQ1", "DRIVE", "EQ2", "DEL1", "Parameters", "processBlock"}};
+   #endif
     
-    template<typename ChainType> void updateCompressor(ChainType& comp) {
-        comp.setRatio(20.0);
-        comp.setRelease(50.0);
-        comp.setAttack(20.0);
-        comp.setThreshold(35.0);
-    };
+    // Bumped by parameterChanged; processBlock only re-reads the parameters
+    // when this differs from the version it last applied
+    std::atomic<int> parameterVersion {0};
+    int appliedParameterVersion {-1};
     
-    double ms2Samples(int ms) {
-        return (getSampleRate() / double(1000)) * ms;
-    }
+    void parameterChanged(const juce::String &parameterID, float newValue) override;
+    void applyChainSettings(const ChainSettings &chainSettings);
+    
+    // The engine's latency as of the last applyChainSettings. setLatencySamples
+    // tells the host synchronously, so processBlock leaves it to
+    // handleAsyncUpdate on the message thread
+    std::atomic<int> engineLatency {0};
+    void handleAsyncUpdate() override;
+    
+    // Programs only write the parameters, processBlock picks them up through
+    // parameterVersion like any other change
+    PresetBank presets;
+    int currentProgram {0};
+    
+    // Oversampling is left out for programs: it moves the latency by several
+    // samples, more than a program change should. Antialiasing and Clipper
+    // do come with a program, and with ADAA on they can move the latency by
+    // a sample. The host is told through handleAsyncUpdate, as for any
+    // other parameter change
+    void setParameters(const ChainSettings &chainSettings, bool includeOversampling);
     
-    double fortyMS = ms2Samples(40);
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RokmanAudioProcessor)
 };
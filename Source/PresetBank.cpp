@@ -0,0 +1,160 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+namespace {
+
+constexpr int stateMagic = ('R' << 24) | ('K' << 16) | ('M' << 8) | 'N';
+
+ChainSettings makeSettings(int mode, bool chorus, bool echo, float drive = 0.0f, float hpf = 0.0f, float tone = 0.0f) {
+    ChainSettings settings;
+    settings.mode = mode;
+    settings.chorus = chorus;
+    settings.echo = echo;
+    settings.drive = drive;
+    settings.hpf = hpf;
+    settings.tone = tone;
+    return settings;
+}
+
+} // namespace
+
+PresetBank::PresetBank() {
+    // The four X100 modes as they come, then the usual combinations with
+    // DELAY 1. Modes: 0 Dist, 1 Edge, 2 Cln1, 3 Cln2
+    presets.add({"Distortion", makeSettings(0, false, false)});
+    presets.add({"Edge", makeSettings(1, false, false)});
+    presets.add({"Clean 1", makeSettings(2, false, false)});
+    presets.add({"Clean 2", makeSettings(3, false, false)});
+    presets.add({"Lead Echo", makeSettings(0, true, true, 3.0f)});
+    presets.add({"Edge Chorus", makeSettings(1, true, false)});
+    presets.add({"Clean Chorus", makeSettings(2, true, false, 0.0f, 0.0f, 0.25f)});
+    presets.add({"Dark Rhythm", makeSettings(0, false, false, -3.0f, -0.5f, -0.5f)});
+
+    numFactoryPresets = presets.size();
+}
+
+const Preset& PresetBank::getPreset(int index) const {
+    return presets.getReference(juce::isPositiveAndBelow(index, presets.size()) ? index : 0);
+}
+
+int PresetBank::addUserPreset(const juce::String& name, const ChainSettings& settings) {
+    presets.add({name, settings});
+    return presets.size() - 1;
+}
+
+void PresetBank::renamePreset(int index, const juce::String& name) {
+    if (juce::isPositiveAndBelow(index, presets.size()) && ! isFactoryPreset(index))
+        presets.getReference(index).name = name;
+}
+
+void PresetBank::removePreset(int index) {
+    if (juce::isPositiveAndBelow(index, presets.size()) && ! isFactoryPreset(index))
+        presets.remove(index);
+}
+
+//==============================================================================
+void PresetBank::writeState(juce::MemoryBlock& destination, const ChainSettings& current, int currentProgram) const {
+    juce::MemoryOutputStream stream(destination, false);
+
+    stream.writeInt(stateMagic);
+    stream.writeByte((char) formatVersion);
+    stream.writeCompressedInt(currentProgram);
+    writeSettings(stream, current);
+
+    stream.writeCompressedInt(presets.size() - numFactoryPresets);
+
+    for (int i = numFactoryPresets; i < presets.size(); ++i) {
+        auto& preset = presets.getReference(i);
+        stream.writeString(preset.name);
+        writeSettings(stream, preset.settings);
+    }
+}
+
+bool PresetBank::readState(const void* data, int sizeInBytes, ChainSettings& current, int& currentProgram) {
+    juce::MemoryInputStream stream(data, (size_t) juce::jmax(0, sizeInBytes), false);
+
+    if (stream.getTotalLength() < 5 || stream.readInt() != stateMagic || stream.readByte() < 1)
+        return false;
+
+    auto program = stream.readCompressedInt();
+    auto settings = readSettings(stream);
+
+    // The user presets of the session replace the ones loaded before
+    juce::Array<Preset> userPresets;
+    auto numUserPresets = stream.readCompressedInt();
+
+    for (int i = 0; i < numUserPresets && ! stream.isExhausted(); ++i) {
+        Preset preset;
+        preset.name = stream.readString();
+        preset.settings = readSettings(stream);
+        userPresets.add(preset);
+    }
+
+    presets.removeRange(numFactoryPresets, presets.size() - numFactoryPresets);
+    presets.addArray(userPresets);
+
+    current = settings;
+    currentProgram = juce::isPositiveAndBelow(program, presets.size()) ? program : -1;
+    return true;
+}
+
+void PresetBank::writeSettings(juce::OutputStream& stream, const ChainSettings& settings) {
+    juce::MemoryOutputStream block;
+
+    block.writeByte((char) settings.mode);
+    block.writeByte((char) settings.oversampling);
+    block.writeByte((char) settings.oversamplingFilter);
+    block.writeByte((char) settings.clipper);
+    block.writeByte((char) ((settings.chorus ? 1 : 0) | (settings.echo ? 2 : 0)));
+    block.writeFloat(settings.drive);
+    block.writeFloat(settings.output);
+    block.writeFloat(settings.hpf);
+    block.writeFloat(settings.tone);
+    block.writeByte((char) settings.antialiasing);
+
+    stream.writeCompressedInt((int) block.getDataSize());
+    stream.write(block.getData(), block.getDataSize());
+}
+
+ChainSettings PresetBank::readSettings(juce::InputStream& stream) {
+    // Fields past the end of the block keep their defaults, fields after the
+    // ones below are skipped
+    juce::MemoryBlock data;
+    stream.readIntoMemoryBlock(data, juce::jmax(0, stream.readCompressedInt()));
+    juce::MemoryInputStream block(data, false);
+
+    ChainSettings settings;
+
+    auto readByte = [&block](int defaultValue, int maximum) {
+        return block.getNumBytesRemaining() >= 1 ? juce::jlimit(0, maximum, (int) (juce::uint8) block.readByte()) : defaultValue;
+    };
+
+    auto readFloat = [&block](float defaultValue, float minimum, float maximum) {
+        auto value = block.getNumBytesRemaining() >= 4 ? block.readFloat() : defaultValue;
+        return std::isfinite(value) ? juce::jlimit(minimum, maximum, value) : defaultValue;
+    };
+
+    settings.mode = readByte(settings.mode, 3);
+    settings.oversampling = readByte(settings.oversampling, 3);
+    settings.oversamplingFilter = readByte(settings.oversamplingFilter, 1);
+    settings.clipper = readByte(settings.clipper, 4);
+
+    auto flags = readByte(0, 255);
+    settings.chorus = (flags & 1) != 0;
+    settings.echo = (flags & 2) != 0;
+
+    settings.drive = readFloat(settings.drive, -12.0f, 12.0f);
+    settings.output = readFloat(settings.output, -24.0f, 12.0f);
+    settings.hpf = readFloat(settings.hpf, -1.0f, 1.0f);
+    settings.tone = readFloat(settings.tone, -1.0f, 1.0f);
+    settings.antialiasing = readByte(settings.antialiasing, 2);
+
+    return settings;
+}
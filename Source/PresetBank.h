@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+
+    Factory and user presets behind the host's program list, and the binary
+    format the plugin state is saved in.
+
+    State, version 2, little endian:
+
+        int32           'RKMN'
+        uint8           format version
+        compressed int  current program, -1 for none
+        settings        the parameters
+        compressed int  number of user presets
+                        per user preset: UTF-8 name, 0 terminated, settings
+
+    Settings are a compressed int byte count followed by Mode, Oversampling,
+    Oversampling Filter and Clipper as one byte each, a byte of flags (bit 0
+    Chorus, bit 1 Echo), then Drive, Output, HPF and Tone as float32, then
+    (version 2) Antialiasing as a byte. Later
+    versions only append, so an older reader takes the fields it knows and
+    skips the rest, and a newer one gives fields missing from an old state
+    their defaults.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+
+struct Preset {
+    juce::String name;
+    ChainSettings settings;
+};
+
+class PresetBank {
+public:
+    PresetBank();
+
+    // Factory presets first, then the user's
+    int getNumPresets() const { return presets.size(); }
+    int getNumFactoryPresets() const { return numFactoryPresets; }
+    bool isFactoryPreset(int index) const { return juce::isPositiveAndBelow(index, numFactoryPresets); }
+
+    // Checked, anything out of range gives the first preset
+    const Preset& getPreset(int index) const;
+
+    // Returns the index of the new preset
+    int addUserPreset(const juce::String& name, const ChainSettings& settings);
+
+    // Factory presets can't be renamed or removed
+    void renamePreset(int index, const juce::String& name);
+    void removePreset(int index);
+
+    void writeState(juce::MemoryBlock& destination, const ChainSettings& current, int currentProgram) const;
+
+    // Replaces the user presets. False, with nothing changed, if data isn't a
+    // state this format can read
+    bool readState(const void* data, int sizeInBytes, ChainSettings& current, int& currentProgram);
+
+    static void writeSettings(juce::OutputStream& stream, const ChainSettings& settings);
+
+    // Clamped to the parameter ranges
+    static ChainSettings readSettings(juce::InputStream& stream);
+
+    static constexpr int formatVersion = 2;
+
+private:
+    juce::Array<Preset> presets;
+    int numFactoryPresets {0};
+};
@@ -0,0 +1,842 @@
+/*
+  ==============================================================================
+
+    RokmanDSP.h
+
+    The stages of the Rokman chain, templated on the sample type so that the
+    same code runs on plain float/double blocks and on blocks of
+    juce::dsp::SIMDRegister, where every lane of a register is one channel.
+
+    Every stage follows the juce::dsp processor interface (prepare, reset,
+    process) so they can be put in a juce::dsp::ProcessorChain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Branch-free log2 and exp2 for gain computers, accurate to about 0.001 dB.
+// The exponent comes straight from the float bits and a quartic covers the
+// rest, so a loop over SIMD lanes vectorises. Both quartics are exact at the
+// ends of their range, exp2(0) is exactly 1 and there are no steps at powers
+// of two.
+//
+// The double versions work the same way on the 52 bit mantissa and the
+// exponent biased by 1023, with series long enough for double precision, so
+// the double engine's compressor doesn't fall back to float accuracy
+namespace FastMath {
+    // x > 0, 0 gives about -127
+    inline float log2(float x) noexcept {
+        juce::uint32 bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+
+        auto exponent = static_cast<float>(static_cast<int>(bits >> 23) - 127);
+
+        // Mantissa in [1, 2)
+        bits = (bits & 0x007fffffu) | 0x3f800000u;
+        float m;
+        std::memcpy(&m, &bits, sizeof(m));
+
+        auto t = m - 1.0f;
+        return exponent + t * (1.4383793f + t * (-0.67588065f + t * (0.31815448f + t * -0.080653158f)));
+    }
+
+    inline float exp2(float x) noexcept {
+        x = std::max(-126.0f, std::min(126.0f, x));
+
+        auto whole = std::floor(x);
+        auto f = x - whole;
+
+        auto bits = static_cast<juce::uint32>(static_cast<int>(whole) + 127) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+
+        return scale * (1.0f + f * (0.69303297f + f * (0.24136979f + f * (0.052054818f + f * 0.013542428f))));
+    }
+
+    // x > 0, 0 gives about -1023. Within 5.0e-16 of std::log2, and of the
+    // result relatively for x near 1
+    inline double log2(double x) noexcept {
+        juce::uint64 bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+
+        auto exponent = static_cast<double>(static_cast<int>(bits >> 52) - 1023);
+
+        // Mantissa in [1, 2), then moved to [sqrt(1/2), sqrt(2)) so that the
+        // series below stays short
+        bits = (bits & 0x000fffffffffffffull) | 0x3ff0000000000000ull;
+        double m;
+        std::memcpy(&m, &bits, sizeof(m));
+
+        auto high = m > 1.4142135623730951;
+        m = high ? m * 0.5 : m;
+        exponent += high ? 1.0 : 0.0;
+
+        // log(m) = 2 atanh(s), an odd series in s with |s| < 0.172
+        auto s = (m - 1.0) / (m + 1.0);
+        auto s2 = s * s;
+        auto series = 1.0 + s2 * (1.0 / 3.0 + s2 * (1.0 / 5.0 + s2 * (1.0 / 7.0 + s2 * (1.0 / 9.0 + s2 * (1.0 / 11.0
+                    + s2 * (1.0 / 13.0 + s2 * (1.0 / 15.0 + s2 * (1.0 / 17.0 + s2 * (1.0 / 19.0 + s2 * (1.0 / 21.0))))))))));
+
+        return exponent + 2.8853900817779268 * s * series;
+    }
+
+    // Within 2 ulp of std::exp2
+    inline double exp2(double x) noexcept {
+        x = std::max(-1022.0, std::min(1023.0, x));
+
+        // Rounded rather than floored, so the series only covers +-0.5
+        auto whole = std::floor(x + 0.5);
+        auto f = (x - whole) * 0.69314718055994531;
+
+        auto bits = static_cast<juce::uint64>(static_cast<juce::int64>(whole) + 1023) << 52;
+        double scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+
+        // e^f, Taylor to the 13th power
+        auto series = 1.0 + f * (1.0 + f * (1.0 / 2.0 + f * (1.0 / 6.0 + f * (1.0 / 24.0 + f * (1.0 / 120.0 + f * (1.0 / 720.0
+                    + f * (1.0 / 5040.0 + f * (1.0 / 40320.0 + f * (1.0 / 362880.0 + f * (1.0 / 3628800.0
+                    + f * (1.0 / 39916800.0 + f * (1.0 / 479001600.0 + f * (1.0 / 6227020800.0)))))))))))));
+
+        return scale * series;
+    }
+}
+
+//==============================================================================
+// Per sample-type helpers, the SIMD specialisation works lane-wise
+template <typename SampleType>
+struct SampleTraits {
+    using NumericType = SampleType;
+    static constexpr size_t numLanes = 1;
+
+    static SampleType broadcast(NumericType x) noexcept { return x; }
+    static SampleType abs(SampleType x) noexcept { return std::abs(x); }
+    static SampleType min(SampleType a, SampleType b) noexcept { return juce::jmin(a, b); }
+    static SampleType max(SampleType a, SampleType b) noexcept { return juce::jmax(a, b); }
+    static SampleType clip(SampleType x, SampleType lo, SampleType hi) noexcept { return juce::jlimit(lo, hi, x); }
+    static SampleType divide(SampleType a, SampleType b) noexcept { return a / b; }
+    static SampleType log2(SampleType x) noexcept { return FastMath::log2(x); }
+    static SampleType exp2(SampleType x) noexcept { return FastMath::exp2(x); }
+
+    // a > b ? ifTrue : ifFalse
+    static SampleType selectGreater(SampleType a, SampleType b, SampleType ifTrue, SampleType ifFalse) noexcept {
+        return a > b ? ifTrue : ifFalse;
+    }
+
+    static NumericType getLane(SampleType x, size_t) noexcept { return x; }
+    static void setLane(SampleType& x, size_t, NumericType value) noexcept { x = value; }
+
+    template <typename Function>
+    static SampleType map(SampleType x, Function&& function) noexcept { return function(x); }
+};
+
+template <typename ElementType>
+struct SampleTraits<juce::dsp::SIMDRegister<ElementType>> {
+    using SampleType = juce::dsp::SIMDRegister<ElementType>;
+    using NumericType = ElementType;
+    static constexpr size_t numLanes = SampleType::SIMDNumElements;
+
+    static SampleType broadcast(NumericType x) noexcept { return SampleType::expand(x); }
+    static SampleType abs(SampleType x) noexcept { return SampleType::abs(x); }
+    static SampleType min(SampleType a, SampleType b) noexcept { return SampleType::min(a, b); }
+    static SampleType max(SampleType a, SampleType b) noexcept { return SampleType::max(a, b); }
+    static SampleType clip(SampleType x, SampleType lo, SampleType hi) noexcept { return SampleType::max(lo, SampleType::min(hi, x)); }
+
+    // SIMDRegister has no division, a fixed-size lane loop vectorises to one
+    static SampleType divide(SampleType a, SampleType b) noexcept {
+        alignas(sizeof(SampleType)) NumericType x[numLanes];
+        alignas(sizeof(SampleType)) NumericType y[numLanes];
+        a.copyToRawArray(x);
+        b.copyToRawArray(y);
+        for (size_t i = 0; i < numLanes; ++i)
+            x[i] /= y[i];
+        return SampleType::fromRawArray(x);
+    }
+
+    static SampleType log2(SampleType x) noexcept { return map(x, [](NumericType v) { return FastMath::log2(v); }); }
+    static SampleType exp2(SampleType x) noexcept { return map(x, [](NumericType v) { return FastMath::exp2(v); }); }
+
+    static SampleType selectGreater(SampleType a, SampleType b, SampleType ifTrue, SampleType ifFalse) noexcept {
+        auto mask = SampleType::greaterThan(a, b);
+        return (ifTrue & mask) + (ifFalse & ~mask);
+    }
+
+    static NumericType getLane(SampleType x, size_t lane) noexcept { return x.get(lane); }
+    static void setLane(SampleType& x, size_t lane, NumericType value) noexcept { x.set(lane, value); }
+
+    // For the few operations SIMDRegister doesn't have (pow, exp...), a
+    // fixed-size loop over the lanes
+    template <typename Function>
+    static SampleType map(SampleType x, Function&& function) noexcept {
+        alignas(sizeof(SampleType)) NumericType lanes[numLanes];
+        x.copyToRawArray(lanes);
+        for (size_t i = 0; i < numLanes; ++i)
+            lanes[i] = function(lanes[i]);
+        return SampleType::fromRawArray(lanes);
+    }
+};
+
+//==============================================================================
+// Runs function(input, output, numSamples) for every channel of the context
+template <typename ProcessContext, typename Function>
+void processChannels(const ProcessContext& context, Function&& function) noexcept {
+    auto&& inputBlock = context.getInputBlock();
+    auto&& outputBlock = context.getOutputBlock();
+    auto numChannels = outputBlock.getNumChannels();
+    auto numSamples = outputBlock.getNumSamples();
+
+    jassert(inputBlock.getNumChannels() == numChannels);
+    jassert(inputBlock.getNumSamples() == numSamples);
+
+    if (context.isBypassed) {
+        if (context.usesSeparateInputAndOutputBlocks())
+            outputBlock.copyFrom(inputBlock);
+        return;
+    }
+
+    for (size_t channel = 0; channel < numChannels; ++channel)
+        function(channel, inputBlock.getChannelPointer(channel), outputBlock.getChannelPointer(channel), numSamples);
+}
+
+//==============================================================================
+// First or second order IIR section, transposed direct form II
+template <typename SampleType>
+class IIRStage {
+public:
+    using NumericType = typename SampleTraits<SampleType>::NumericType;
+
+    // Copies the values, so it doesn't allocate and is safe on the audio thread
+    template <typename CoefficientType>
+    void setCoefficients(const juce::dsp::IIR::Coefficients<CoefficientType>& newCoefficients) noexcept {
+        auto* c = newCoefficients.getRawCoefficients();
+
+        if (newCoefficients.getFilterOrder() == 1) {
+            setCoefficients(c[0], c[1], CoefficientType(0), c[2], CoefficientType(0));
+        } else {
+            jassert(newCoefficients.getFilterOrder() == 2);
+            setCoefficients(c[0], c[1], c[2], c[3], c[4]);
+        }
+    }
+
+    template <typename CoefficientType>
+    void setCoefficients(CoefficientType newB0, CoefficientType newB1, CoefficientType newB2, CoefficientType newA1, CoefficientType newA2) noexcept {
+        b0 = SampleTraits<SampleType>::broadcast(static_cast<NumericType>(newB0));
+        b1 = SampleTraits<SampleType>::broadcast(static_cast<NumericType>(newB1));
+        b2 = SampleTraits<SampleType>::broadcast(static_cast<NumericType>(newB2));
+        a1 = SampleTraits<SampleType>::broadcast(static_cast<NumericType>(newA1));
+        a2 = SampleTraits<SampleType>::broadcast(static_cast<NumericType>(newA2));
+    }
+
+    void prepare(const juce::dsp::ProcessSpec& spec) {
+        state.resize(spec.numChannels);
+        reset();
+    }
+
+    void reset() noexcept {
+        for (auto& s : state)
+            s = { SampleType(), SampleType() };
+    }
+
+    template <typename ProcessContext>
+    void process(const ProcessContext& context) noexcept {
+        processChannels(context, [this](size_t channel, const SampleType* input, SampleType* output, size_t numSamples) {
+            auto s1 = state[channel][0];
+            auto s2 = state[channel][1];
+
+            for (size_t i = 0; i < numSamples; ++i) {
+                auto x = input[i];
+                auto y = b0 * x + s1;
+                s1 = b1 * x - a1 * y + s2;
+                s2 = b2 * x - a2 * y;
+                output[i] = y;
+            }
+
+            state[channel] = { s1, s2 };
+        });
+    }
+
+private:
+    SampleType b0 {SampleTraits<SampleType>::broadcast(1)}, b1 {}, b2 {}, a1 {}, a2 {};
+    std::vector<std::array<SampleType, 2>> state;
+};
+
+//==============================================================================
+// A run of up to MaxSections IIR sections in one pass: every sample goes
+// through all of them before the next one is read, with the coefficients and
+// state held in locals. The loop is instantiated for every number of
+// sections, so the inner loop over sections unrolls.
+//
+// Sections are given as b0..a2 like an IIRStage, but run as trapezoidal
+// state variable filters with the same response. In transposed direct form
+// the rounding of every sample is amplified by 1 / A(1), which for the 50
+// and 80 Hz low shelves is in the thousands and grows fourfold with every
+// octave of sample rate; in float that alone was -63 dBFS of error at
+// 96 kHz. The state variable filter's states are integrators, they don't
+// amplify it, and a section stays about 100 dB under its signal up to
+// 192 kHz.
+template <typename SampleType, int MaxSections>
+class BiquadCascade {
+public:
+    using NumericType = typename SampleTraits<SampleType>::NumericType;
+
+    static constexpr int maximumNumSections = MaxSections;
+
+    // Real-time safe. Sections past numSections are skipped
+    void setNumSections(int newNumSections) noexcept {
+        numSections = juce::jlimit(0, MaxSections, newNumSections);
+    }
+
+    int getNumSections() const noexcept { return numSections; }
+
+    // Copies the values, so it doesn't allocate and is safe on the audio thread
+    template <typename CoefficientType>
+    void setSection(int index, const juce::dsp::IIR::Coefficients<CoefficientType>& newCoefficients) noexcept {
+        auto* c = newCoefficients.getRawCoefficients();
+
+        if (newCoefficients.getFilterOrder() == 1) {
+            setSection(index, c[0], c[1], CoefficientType(0), c[2], CoefficientType(0));
+        } else {
+            jassert(newCoefficients.getFilterOrder() == 2);
+            setSection(index, c[0], c[1], c[2], c[3], c[4]);
+        }
+    }
+
+    // Worked out in double whatever the coefficients come in, the low
+    // shelves' 1 + a1 + a2 is the difference of numbers near 2 and 1
+    template <typename CoefficientType>
+    void setSection(int index, CoefficientType b0, CoefficientType b1, CoefficientType b2, CoefficientType a1, CoefficientType a2) noexcept {
+        jassert(juce::isPositiveAndBelow(index, MaxSections));
+
+        // A(1) and A(-1), both positive for a stable section
+        auto sum = 1.0 + (double) a1 + (double) a2;
+        auto alternating = 1.0 - (double) a1 + (double) a2;
+        jassert(sum > 0.0 && alternating > 0.0);
+
+        // g = tan(w / 2) of the prewarped cutoff. The input, band pass and
+        // low pass outputs mixed by m0, m1 and m2 give back B(z) / A(z)
+        auto g = std::sqrt(sum / alternating);
+        auto m0 = ((double) b0 - (double) b1 + (double) b2) / alternating;
+        auto bandPass = 0.5 * ((double) b0 - (double) b2 - m0 * (1.0 - (double) a2));
+        auto lowPass = 0.5 * ((double) b1 - m0 * (double) a1);
+
+        auto broadcast = [](double value) { return SampleTraits<SampleType>::broadcast(static_cast<NumericType>(value)); };
+        sections[(size_t) index] = { broadcast(0.25 * alternating), broadcast(0.25 * g * alternating), broadcast(0.25 * sum),
+                                     broadcast(m0), broadcast(4.0 * bandPass / (g * alternating)), broadcast(4.0 * lowPass / sum) };
+    }
+
+    void prepare(const juce::dsp::ProcessSpec& spec) {
+        state.resize(spec.numChannels);
+        reset();
+    }
+
+    void reset() noexcept {
+        for (auto& s : state)
+            s.fill(SampleType());
+    }
+
+    template <typename ProcessContext>
+    void process(const ProcessContext& context) noexcept {
+        processChannels(context, [this](size_t channel, const SampleType* input, SampleType* output, size_t numSamples) {
+            processSections<1>(input, output, numSamples, state[channel]);
+        });
+    }
+
+private:
+    // g1 = 1 / (1 + g (g + k)), g2 = g g1, g3 = g g2 with k = 1 / Q, and
+    // the output mix. Passes the input through until it is set
+    struct Section {
+        SampleType g1 {}, g2 {}, g3 {};
+        SampleType m0 {SampleTraits<SampleType>::broadcast(1)}, m1 {}, m2 {};
+    };
+
+    using State = std::array<SampleType, 2 * MaxSections>;
+
+    // Finds the instantiation for numSections
+    template <int N>
+    void processSections(const SampleType* input, SampleType* output, size_t numSamples, State& s) noexcept {
+        if constexpr (N <= MaxSections) {
+            if (N == numSections)
+                run<N>(input, output, numSamples, s);
+            else
+                processSections<N + 1>(input, output, numSamples, s);
+        } else if (input != output) {
+            std::copy(input, input + numSamples, output);
+        }
+    }
+
+    template <int N>
+    void run(const SampleType* input, SampleType* output, size_t numSamples, State& s) noexcept {
+        std::array<Section, N> c;
+        std::array<SampleType, 2 * N> z;
+
+        for (size_t k = 0; k < (size_t) N; ++k) {
+            c[k] = sections[k];
+            z[2 * k] = s[2 * k];
+            z[2 * k + 1] = s[2 * k + 1];
+        }
+
+        for (size_t i = 0; i < numSamples; ++i) {
+            auto x = input[i];
+
+            // z[2k] and z[2k + 1] are the band pass and low pass integrators
+            for (size_t k = 0; k < (size_t) N; ++k) {
+                auto v3 = x - z[2 * k + 1];
+                auto v1 = c[k].g1 * z[2 * k] + c[k].g2 * v3;
+                auto v2 = z[2 * k + 1] + c[k].g2 * z[2 * k] + c[k].g3 * v3;
+                z[2 * k] = v1 + v1 - z[2 * k];
+                z[2 * k + 1] = v2 + v2 - z[2 * k + 1];
+                x = c[k].m0 * x + c[k].m1 * v1 + c[k].m2 * v2;
+            }
+
+            output[i] = x;
+        }
+
+        for (size_t k = 0; k < 2 * (size_t) N; ++k)
+            s[k] = z[k];
+    }
+
+    std::array<Section, MaxSections> sections;
+    int numSections {0};
+    std::vector<State> state;
+};
+
+//==============================================================================
+// Same behaviour as juce::dsp::Compressor (peak ballistics, hard knee), but
+// usable with SIMD registers. The gain is worked out in the log2 domain
+// without branches, every lane takes the same path whether it is being
+// compressed or not
+template <typename SampleType>
+class CompressorStage {
+public:
+    using NumericType = typename SampleTraits<SampleType>::NumericType;
+
+    void setThreshold(NumericType newThresholdDecibels) noexcept { thresholdDecibels = newThresholdDecibels; update(); }
+    void setRatio(NumericType newRatio) noexcept { jassert(newRatio >= 1); ratio = newRatio; update(); }
+    void setAttack(NumericType newAttackMs) noexcept { attackTime = newAttackMs; update(); }
+    void setRelease(NumericType newReleaseMs) noexcept { releaseTime = newReleaseMs; update(); }
+
+    void prepare(const juce::dsp::ProcessSpec& spec) {
+        jassert(spec.sampleRate > 0);
+        sampleRate = spec.sampleRate;
+        envelope.resize(spec.numChannels);
+        minimumGain.resize(spec.numChannels);
+        update();
+        reset();
+    }
+
+    void reset() noexcept {
+        for (auto& e : envelope)
+            e = SampleType();
+
+        for (auto& g : minimumGain)
+            g = SampleTraits<SampleType>::broadcast(1);
+    }
+
+    // The lowest gain applied during the last block, per lane. Gathered in
+    // the processing loop, so metering costs no extra pass
+    SampleType getMinimumGain(size_t channel) const noexcept { return minimumGain[channel]; }
+
+    template <typename ProcessContext>
+    void process(const ProcessContext& context) noexcept {
+        using Traits = SampleTraits<SampleType>;
+
+        const auto attack = Traits::broadcast(attackCoefficient);
+        const auto release = Traits::broadcast(releaseCoefficient);
+        const auto thresholdLog = Traits::broadcast(thresholdLog2);
+        const auto slope = Traits::broadcast(ratioInverse - NumericType(1));
+        const auto zero = Traits::broadcast(0);
+
+        processChannels(context, [&](size_t channel, const SampleType* input, SampleType* output, size_t numSamples) {
+            auto env = envelope[channel];
+            auto lowest = Traits::broadcast(1);
+
+            for (size_t i = 0; i < numSamples; ++i) {
+                auto x = input[i];
+                auto rectified = Traits::abs(x);
+                auto cte = Traits::selectGreater(rectified, env, attack, release);
+                env = rectified + cte * (env - rectified);
+
+                // (env / threshold)^(1 / ratio - 1) above the threshold, 1 below
+                auto overshoot = Traits::max(zero, Traits::log2(env) - thresholdLog);
+                auto gain = Traits::exp2(slope * overshoot);
+
+                lowest = Traits::min(lowest, gain);
+                output[i] = gain * x;
+            }
+
+            envelope[channel] = env;
+            minimumGain[channel] = lowest;
+        });
+    }
+
+private:
+    void update() noexcept {
+        // Same approximation as the envelope goes through, so the knee is exact
+        auto threshold = juce::Decibels::decibelsToGain(thresholdDecibels, NumericType(-200));
+        thresholdLog2 = FastMath::log2(threshold);
+        ratioInverse = NumericType(1) / ratio;
+
+        auto expFactor = -2.0 * juce::MathConstants<double>::pi * 1000.0 / sampleRate;
+        attackCoefficient = attackTime < NumericType(1.0e-3) ? NumericType(0) : static_cast<NumericType>(std::exp(expFactor / attackTime));
+        releaseCoefficient = releaseTime < NumericType(1.0e-3) ? NumericType(0) : static_cast<NumericType>(std::exp(expFactor / releaseTime));
+    }
+
+    NumericType thresholdDecibels {0}, ratio {1}, attackTime {1}, releaseTime {100};
+    NumericType thresholdLog2 {0}, ratioInverse {1};
+    NumericType attackCoefficient {0}, releaseCoefficient {0};
+    double sampleRate {44100.0};
+
+    std::vector<SampleType> envelope;
+    std::vector<SampleType> minimumGain;
+};
+
+//==============================================================================
+template <typename SampleType>
+class GainStage {
+public:
+    using NumericType = typename SampleTraits<SampleType>::NumericType;
+
+    void setGainDecibels(NumericType newGainDecibels) noexcept {
+        gain = SampleTraits<SampleType>::broadcast(juce::Decibels::decibelsToGain(newGainDecibels, NumericType(-100)));
+    }
+
+    void prepare(const juce::dsp::ProcessSpec&) {}
+    void reset() noexcept {}
+
+    template <typename ProcessContext>
+    void process(const ProcessContext& context) noexcept {
+        processChannels(context, [this](size_t, const SampleType* input, SampleType* output, size_t numSamples) {
+            for (size_t i = 0; i < numSamples; ++i)
+                output[i] = gain * input[i];
+        });
+    }
+
+private:
+    SampleType gain {SampleTraits<SampleType>::broadcast(1)};
+};
+
+//==============================================================================
+// Ring buffer for one channel, sized to a power of two so that wrapping is a
+// mask. Delays count back from the last pushed sample, 0 being that sample
+template <typename SampleType>
+class DelayBuffer {
+public:
+    // Allocates
+    void setMaximumDelay(int maximumDelayInSamples) {
+        auto size = juce::nextPowerOfTwo(juce::jmax(2, maximumDelayInSamples + 1));
+        data.assign((size_t) size, SampleType());
+        mask = size - 1;
+        position = 0;
+    }
+
+    int getMaximumDelay() const noexcept { return mask; }
+
+    void clear() noexcept {
+        std::fill(data.begin(), data.end(), SampleType());
+        position = 0;
+    }
+
+    // Both buffers have to have the same size, doesn't allocate
+    void copyFrom(const DelayBuffer& other) noexcept {
+        jassert(other.data.size() == data.size());
+        std::copy(other.data.begin(), other.data.end(), data.begin());
+        position = other.position;
+    }
+
+    // numSamples of the other ring from index start on, wrapping, without
+    // touching the write position. Same size again
+    void copyRangeFrom(const DelayBuffer& other, int start, int numSamples) noexcept {
+        jassert(other.data.size() == data.size() && numSamples <= mask + 1);
+
+        start &= mask;
+        auto first = juce::jmin(numSamples, mask + 1 - start);
+        std::copy_n(other.data.begin() + start, first, data.begin() + start);
+        std::copy_n(other.data.begin(), numSamples - first, data.begin());
+    }
+
+    int getWritePosition() const noexcept { return position; }
+    void setWritePosition(int newPosition) noexcept { position = newPosition & mask; }
+
+    void push(SampleType x) noexcept {
+        position = (position + 1) & mask;
+        data[(size_t) position] = x;
+    }
+
+    SampleType read(int delay) const noexcept {
+        jassert(juce::isPositiveAndNotGreaterThan(delay, mask));
+        return data[(size_t) ((position - delay) & mask)];
+    }
+
+private:
+    std::vector<SampleType> data;
+    int mask {0}, position {0};
+};
+
+//==============================================================================
+// Runs a processor at 1x, 2x, 4x or 8x the sample rate around
+// juce::dsp::Oversampling. Oversampling has no SIMDRegister support, so on
+// SIMD blocks the active lanes are split into plain channels around the
+// oversampled part; at 1x the processor runs directly on the block.
+//
+// Every factor and filter type is built in prepare, switching between them
+// doesn't allocate. The wrapped processor is prepared once for the highest
+// rate, so it must not depend on the sample rate.
+//
+// With linked lanes (dual mono) only lane 0 is oversampled, through its own
+// one-channel oversamplers and processor, and the result is copied to the
+// other lanes. The last primeLength inputs of every lane are kept, and the
+// path that takes over on a link change is reset and run over them first,
+// so it picks up with the state it would have had.
+template <typename SampleType, template <typename> class ProcessorType>
+class OversampledStage {
+public:
+    using NumericType = typename SampleTraits<SampleType>::NumericType;
+    using Oversampler = juce::dsp::Oversampling<NumericType>;
+    using FilterType = typename Oversampler::FilterType;
+
+    // 1x, 2x, 4x, 8x
+    static constexpr int numFactors = 4;
+
+    // Base-rate samples used to warm up a path before it takes over, longer
+    // than any of the oversampling filters' memory
+    static constexpr int primeLength = 256;
+
+    // How many lanes of each SIMD register carry audio, set it before prepare
+    void setNumActiveLanes(int newNumActiveLanes) {
+        numActiveLanes = (size_t) juce::jlimit(1, (int) SampleTraits<SampleType>::numLanes, newNumActiveLanes);
+    }
+
+    // Real-time safe, takes effect at the next block
+    void setLanesLinked(bool shouldBeLinked) noexcept { linkRequested = shouldBeLinked; }
+    bool areLanesLinked() const noexcept { return linked; }
+
+    // Linking only saves anything on the oversampled path, at 1x every lane
+    // goes through the direct processor either way
+    bool canLinkLanes() const noexcept { return canLink && current != nullptr; }
+
+    // Calls function on the base-rate and on the oversampled processors, use
+    // it to set parameters on all of them
+    template <typename Function>
+    void forEachProcessor(Function&& function) {
+        function(direct);
+        function(oversampled);
+        function(linkedOversampled);
+    }
+
+    void setOversampling(int newFactorIndex, FilterType newFilterType) noexcept {
+        newFactorIndex = juce::jlimit(0, numFactors - 1, newFactorIndex);
+
+        if (newFactorIndex == factorIndex && newFilterType == filterType)
+            return;
+
+        factorIndex = newFactorIndex;
+        filterType = newFilterType;
+
+        auto type = filterTypeIndex(filterType);
+        current = factorIndex == 0 ? nullptr : oversamplers[type][(size_t) factorIndex - 1].get();
+        currentLinked = factorIndex == 0 ? nullptr : linkedOversamplers[type][(size_t) factorIndex - 1].get();
+
+        if (current != nullptr) {
+            current->reset();
+            currentLinked->reset();
+        }
+
+        // Inputs from another rate are no use for priming
+        history.clear();
+    }
+
+    int getFactor() const noexcept { return 1 << factorIndex; }
+
+    // Base-rate samples, the oversampling filters' and whatever the
+    // processor itself delays by at the rate it runs at
+    NumericType getLatencyInSamples() const noexcept {
+        auto latency = current != nullptr ? current->getLatencyInSamples() : NumericType(0);
+
+        if constexpr (requires { direct.getLatencyInSamples(); })
+            latency += current != nullptr ? oversampled.getLatencyInSamples() / (NumericType) getFactor()
+                                          : direct.getLatencyInSamples();
+
+        return latency;
+    }
+
+    void prepare(const juce::dsp::ProcessSpec& spec) {
+        constexpr auto maxFactor = 1 << (numFactors - 1);
+        const auto numLaneChannels = SampleTraits<SampleType>::numLanes > 1 ? spec.numChannels * numActiveLanes
+                                                                           : (size_t) spec.numChannels;
+        const auto maximumBlockSize = juce::jmax((size_t) spec.maximumBlockSize, (size_t) primeLength);
+
+        // Linking only pays off with more than one lane in a single register
+        canLink = SampleTraits<SampleType>::numLanes > 1 && spec.numChannels == 1 && numActiveLanes > 1;
+
+        direct.prepare(spec);
+        oversampled.prepare({ spec.sampleRate * maxFactor, (juce::uint32) maximumBlockSize * maxFactor, (juce::uint32) numLaneChannels });
+        linkedOversampled.prepare({ spec.sampleRate * maxFactor, (juce::uint32) maximumBlockSize * maxFactor, 1 });
+
+        for (auto type : { Oversampler::filterHalfBandPolyphaseIIR, Oversampler::filterHalfBandFIREquiripple }) {
+            for (int i = 1; i < numFactors; ++i) {
+                auto& oversampler = oversamplers[filterTypeIndex(type)][(size_t) i - 1];
+                oversampler = std::make_unique<Oversampler>(numLaneChannels, (size_t) i, type, true, true);
+                oversampler->initProcessing(maximumBlockSize);
+
+                auto& linkedOversampler = linkedOversamplers[filterTypeIndex(type)][(size_t) i - 1];
+                linkedOversampler = std::make_unique<Oversampler>(1, (size_t) i, type, true, true);
+                linkedOversampler->initProcessing(maximumBlockSize);
+            }
+        }
+
+        laneBuffer.setSize((int) numLaneChannels, (int) spec.maximumBlockSize);
+        history.setSize((int) numLaneChannels, primeLength);
+        primeBuffer.setSize((int) numLaneChannels, primeLength);
+        history.clear();
+
+        linked = false;
+
+        auto newFactorIndex = factorIndex;
+        factorIndex = -1;
+        setOversampling(newFactorIndex, filterType);
+    }
+
+    void reset() noexcept {
+        direct.reset();
+        oversampled.reset();
+        linkedOversampled.reset();
+        history.clear();
+
+        for (auto* set : { &oversamplers, &linkedOversamplers })
+            for (auto& type : *set)
+                for (auto& oversampler : type)
+                    if (oversampler != nullptr)
+                        oversampler->reset();
+    }
+
+    template <typename ProcessContext>
+    void process(const ProcessContext& context) noexcept {
+        if (current == nullptr || context.isBypassed) {
+            linked = canLink && linkRequested;
+            direct.process(context);
+            return;
+        }
+
+        auto&& inputBlock = context.getInputBlock();
+        auto&& outputBlock = context.getOutputBlock();
+        const auto numSamples = outputBlock.getNumSamples();
+
+        if constexpr (SampleTraits<SampleType>::numLanes > 1) {
+            constexpr auto numLanes = SampleTraits<SampleType>::numLanes;
+            const auto numSIMDChannels = outputBlock.getNumChannels();
+
+            for (size_t channel = 0; channel < numSIMDChannels; ++channel) {
+                auto* source = reinterpret_cast<const NumericType*>(inputBlock.getChannelPointer(channel));
+
+                for (size_t lane = 0; lane < numActiveLanes; ++lane) {
+                    auto* destination = laneBuffer.getWritePointer((int) (channel * numActiveLanes + lane));
+
+                    for (size_t i = 0; i < numSamples; ++i)
+                        destination[i] = source[i * numLanes + lane];
+                }
+            }
+
+            juce::dsp::AudioBlock<NumericType> laneBlock(laneBuffer);
+            auto block = laneBlock.getSubBlock(0, numSamples);
+
+            if (canLink && linkRequested != linked) {
+                linked = linkRequested;
+                primeFromHistory();
+            }
+
+            if (canLink)
+                pushHistory(numSamples);
+
+            if (linked) {
+                auto lane0 = block.getSingleChannelBlock(0);
+                processOversampled(*currentLinked, linkedOversampled, lane0);
+            } else {
+                processOversampled(*current, oversampled, block);
+            }
+
+            for (size_t channel = 0; channel < numSIMDChannels; ++channel) {
+                auto* destination = reinterpret_cast<NumericType*>(outputBlock.getChannelPointer(channel));
+
+                for (size_t lane = 0; lane < numActiveLanes; ++lane) {
+                    auto* source = laneBuffer.getReadPointer(linked ? 0 : (int) (channel * numActiveLanes + lane));
+
+                    for (size_t i = 0; i < numSamples; ++i)
+                        destination[i * numLanes + lane] = source[i];
+                }
+            }
+        } else {
+            if (context.usesSeparateInputAndOutputBlocks())
+                outputBlock.copyFrom(inputBlock);
+
+            juce::dsp::AudioBlock<NumericType> block(outputBlock);
+            processOversampled(*current, oversampled, block);
+        }
+    }
+
+private:
+    template <typename Processor>
+    static void processOversampled(Oversampler& oversampler, Processor& processor, juce::dsp::AudioBlock<NumericType>& block) noexcept {
+        auto upsampled = oversampler.processSamplesUp(block);
+        juce::dsp::ProcessContextReplacing<NumericType> upsampledContext(upsampled);
+        processor.process(upsampledContext);
+        oversampler.processSamplesDown(block);
+    }
+
+    // Runs the path that is taking over on the kept inputs, from a clean state
+    void primeFromHistory() noexcept {
+        primeBuffer.makeCopyOf(history, true);
+        juce::dsp::AudioBlock<NumericType> primeBlock(primeBuffer);
+
+        if (linked) {
+            currentLinked->reset();
+            linkedOversampled.reset();
+
+            auto lane0 = primeBlock.getSingleChannelBlock(0);
+            processOversampled(*currentLinked, linkedOversampled, lane0);
+        } else {
+            current->reset();
+            oversampled.reset();
+            processOversampled(*current, oversampled, primeBlock);
+        }
+    }
+
+    // Appends the block's inputs, still in laneBuffer, to the history
+    void pushHistory(size_t numSamples) noexcept {
+        const auto numNew = (int) juce::jmin(numSamples, (size_t) primeLength);
+        const auto numKept = primeLength - numNew;
+
+        for (int channel = 0; channel < history.getNumChannels(); ++channel) {
+            auto* destination = history.getWritePointer(channel);
+
+            std::memmove(destination, destination + numNew, (size_t) numKept * sizeof(NumericType));
+            std::memcpy(destination + numKept, laneBuffer.getReadPointer(channel, (int) numSamples - numNew), (size_t) numNew * sizeof(NumericType));
+        }
+    }
+
+    static size_t filterTypeIndex(FilterType type) noexcept {
+        return type == Oversampler::filterHalfBandPolyphaseIIR ? 0 : 1;
+    }
+
+    using OversamplerSet = std::array<std::array<std::unique_ptr<Oversampler>, numFactors - 1>, 2>;
+
+    ProcessorType<SampleType> direct;
+    ProcessorType<NumericType> oversampled;
+    ProcessorType<NumericType> linkedOversampled;
+
+    OversamplerSet oversamplers, linkedOversamplers;
+    Oversampler* current {nullptr};
+    Oversampler* currentLinked {nullptr};
+    int factorIndex {0};
+    FilterType filterType {Oversampler::filterHalfBandPolyphaseIIR};
+
+    size_t numActiveLanes {SampleTraits<SampleType>::numLanes};
+    juce::AudioBuffer<NumericType> laneBuffer;
+
+    bool canLink {false};
+    bool linkRequested {false};
+    bool linked {false};
+    juce::AudioBuffer<NumericType> history, primeBuffer;
+};
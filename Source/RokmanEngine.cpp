@@ -0,0 +1,507 @@
+/*
+  ==============================================================================
+
+    RokmanEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "RokmanEngine.h"
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::prepare(double sampleRate, int newMaximumBlockSize, int newNumChannels) {
+    jassert(newNumChannels <= getMaximumNumChannels());
+
+    // Hosts are allowed to send more than they announced, process splits
+    // whatever comes into blocks of this size
+    blockSize = juce::jlimit(1, subBlockSize, newMaximumBlockSize);
+    numChannels = juce::jlimit(0, getMaximumNumChannels(), newNumChannels);
+
+    // One SIMD "channel" carries every audio channel
+    juce::dsp::ProcessSpec spec;
+    spec.maximumBlockSize = (juce::uint32) blockSize;
+    spec.numChannels = 1;
+    spec.sampleRate = sampleRate;
+
+    interleaved = juce::dsp::AudioBlock<SIMDType>(interleavedBlockData, 1, (size_t) blockSize);
+    interleaved.clear();
+    subBlockPosition = 0;
+
+    // Only the lanes holding audio go through the oversampling filters
+    chain.template get<ChainPositions::DRIVE>().setNumActiveLanes(juce::jmax(1, numChannels));
+
+    // 100 ms of identical channels before they count as dual mono
+    dualMonoHoldSamples = (int) (sampleRate * 0.1);
+    identicalSamples = 0;
+
+    // The filters ring out well within the extra 50 ms
+    idleHoldSamples = (int) std::ceil(sampleRate * (DelayLine::getMaximumDelaySeconds() + 0.05));
+    silentSamples = 0;
+    idle = false;
+
+    chain.prepare(spec);
+
+    // Every mode gets its coefficients designed here, setMode and the
+    // controls only interpolate between them
+    coefficientBank.prepare(sampleRate);
+
+    // Keeps the targets, jumps to them
+    for (auto* smoother : {&driveGain, &outputGain})
+        smoother->reset(sampleRate, smoothingTime);
+
+    for (auto* smoother : {&hpfShift, &toneShift})
+        smoother->reset(sampleRate, smoothingTime);
+
+    // Compressor 12
+    auto& comp = chain.template get<ChainPositions::Comp>();
+    comp.setRatio(20.0f);
+    comp.setRelease(50.0f);
+    comp.setAttack(20.0f);
+    comp.setThreshold(35.0f);
+
+    // AD 16, OPAMP 16 and OPAMP2 16 are part of the bank's EQ1 and EQ2
+    chain.template get<ChainPositions::DRIVE>().forEachProcessor([](auto& drive) {
+        drive.setDrive(35.0f);
+        drive.setCeiling(1.4f);
+    });
+
+    // The bank was rebuilt, so the mode has to be applied again
+    auto mode = juce::jmax(0, currentMode);
+    currentMode = -1;
+    setMode(mode);
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::reset() {
+    resetAllButDelays();
+    chain.template get<ChainPositions::DEL1>().reset();
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::resetAllButDelays() noexcept {
+    // The output jumps anyway, so the controls do too
+    driveGain.setCurrentAndTargetValue(driveGain.getTargetValue());
+    outputGain.setCurrentAndTargetValue(outputGain.getTargetValue());
+    hpfShift.setCurrentAndTargetValue(hpfShift.getTargetValue());
+    toneShift.setCurrentAndTargetValue(toneShift.getTargetValue());
+
+    if (currentMode >= 0)
+        updateFilters();
+
+    chain.template get<ChainPositions::HPF>().reset();
+    chain.template get<ChainPositions::Comp>().reset();
+    chain.template get<ChainPositions::EQ1>().reset();
+    chain.template get<ChainPositions::DRIVE>().reset();
+    chain.template get<ChainPositions::EQ2>().reset();
+
+    minimumGain = SIMDType::expand(FloatType(1));
+    identicalSamples = 0;
+    chain.template get<ChainPositions::DRIVE>().setLanesLinked(false);
+
+    silentSamples = 0;
+    idle = false;
+
+    subBlockPosition = 0;
+    filtersBehind = false;
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::setSubBlockSize(int numSamples) {
+    subBlockSize = juce::jlimit(minimumSubBlockSize, maximumSubBlockSize, numSamples);
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::setMode(int mode) {
+    if (mode == currentMode)
+        return;
+
+    currentMode = juce::jlimit(0, CoefficientBank::numModes - 1, mode);
+    updateFilters();
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::setDrive(float decibels) {
+    driveGain.setTargetValue(juce::Decibels::decibelsToGain(decibels));
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::setOutputLevel(float decibels) {
+    outputGain.setTargetValue(juce::Decibels::decibelsToGain(decibels));
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::setHPFShift(float octaves) {
+    hpfShift.setTargetValue(juce::jlimit(-CoefficientBank::shiftRange, CoefficientBank::shiftRange, octaves));
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::setTone(float octaves) {
+    toneShift.setTargetValue(juce::jlimit(-CoefficientBank::shiftRange, CoefficientBank::shiftRange, octaves));
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::updateFilters() noexcept {
+    const auto& table = coefficientBank[currentMode];
+
+    // HPF 11
+    auto hpf = interpolate(table.hpf, hpfShift.getCurrentValue());
+    chain.template get<ChainPositions::HPF>().setCoefficients(hpf[0], hpf[1], hpf[2], hpf[3], hpf[4]);
+
+    // Everything else up to DRIVE, or up to DEL1 in the clean modes. Drive
+    // moves OPAMP 16 and, the other way, OPAMP2 16
+    auto drive = driveGain.getCurrentValue();
+    setSections(chain.template get<ChainPositions::EQ1>(), table.eq1, table.numEQ1, toneShift.getCurrentValue(), table.opampSection, drive);
+
+    // Between DRIVE and DEL1, the X100's own EQ with the Circuit curve
+    auto circuit = circuitTone && table.numCircuitEQ2 > 0;
+    setSections(chain.template get<ChainPositions::EQ2>(), circuit ? table.circuitEQ2 : table.eq2, circuit ? table.numCircuitEQ2 : table.numEQ2,
+                toneShift.getCurrentValue(), table.opamp2Section, 1.0f / drive);
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::setChorusEcho(bool chorus, bool echo) {
+    auto& delay = chain.template get<ChainPositions::DEL1>();
+    delay.setChorusEnabled(chorus);
+    delay.setEchoEnabled(echo);
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::setChorusSign(int channel, FloatType sign) {
+    if (juce::isPositiveAndBelow(channel, getMaximumNumChannels()))
+        chain.template get<ChainPositions::DEL1>().setChorusSign((size_t) channel, sign);
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::setChainSettings(const ChainSettings& settings) {
+    setMode(settings.mode);
+    setShaperCurve(settings.clipper);
+    setAntialiasing(settings.antialiasing);
+    setChorusEcho(settings.chorus, settings.echo);
+    setOversampling(settings.oversampling, settings.oversamplingFilter);
+
+    setDrive(settings.drive);
+    setOutputLevel(settings.output);
+    setHPFShift(settings.hpf);
+    setTone(settings.tone);
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::setStartPosition(juce::int64 numSamples) {
+    chain.template get<ChainPositions::DEL1>().setLFOPosition(numSamples);
+}
+
+template <typename FloatType>
+double BasicRokmanEngine<FloatType>::getTailLengthSeconds(const ChainSettings& settings) {
+    // The slowest filter, the 50 Hz LBEQ shelf, is 120 dB down after about
+    // 60 ms, the compressor only ever lowers the level
+    return DelayLine::getTailSeconds(settings.echo) + 0.1;
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::startDelayStateCopy(const BasicRokmanEngine& source) {
+    resetAllButDelays();
+    chain.template get<ChainPositions::DEL1>().startCopyFrom(source.chain.template get<ChainPositions::DEL1>());
+}
+
+template <typename FloatType>
+bool BasicRokmanEngine<FloatType>::copyDelayState(const BasicRokmanEngine& source, int numSamples, int samplesToDeadline) {
+    return chain.template get<ChainPositions::DEL1>().continueCopyFrom(source.chain.template get<ChainPositions::DEL1>(), numSamples, samplesToDeadline);
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::setOversampling(int factorIndex, int filterType) {
+    using Oversampler = typename DriveSection::Oversampler;
+
+    chain.template get<ChainPositions::DRIVE>().setOversampling(factorIndex, filterType == 0 ? Oversampler::filterHalfBandPolyphaseIIR
+                                                                                   : Oversampler::filterHalfBandFIREquiripple);
+}
+
+template <typename FloatType>
+int BasicRokmanEngine<FloatType>::getLatencySamples() const {
+    return juce::roundToInt(chain.template get<ChainPositions::DRIVE>().getLatencyInSamples());
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::setShaperCurve(int curve) {
+    auto newCurve = static_cast<ShaperCurve>(juce::jlimit(0, (int) ShaperCurve::Circuit, curve));
+
+    chain.template get<ChainPositions::DRIVE>().forEachProcessor([newCurve](auto& drive) {
+        drive.setCurve(newCurve);
+    });
+
+    auto circuit = newCurve == ShaperCurve::Circuit;
+
+    // A different cascade takes over EQ2, the old one's state means nothing
+    // to it and would ring out through the presence peak
+    if (circuit != circuitTone) {
+        circuitTone = circuit;
+        chain.template get<ChainPositions::EQ2>().reset();
+
+        if (currentMode >= 0)
+            updateFilters();
+    }
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::setAntialiasing(int order) {
+    auto antialiasing = static_cast<ShaperAntialiasing>(juce::jlimit(0, (int) ShaperAntialiasing::SecondOrder, order));
+
+    chain.template get<ChainPositions::DRIVE>().forEachProcessor([antialiasing](auto& drive) {
+        drive.setAntialiasing(antialiasing);
+    });
+}
+
+// One switch per block, everything below it is straight-line code for the mode
+template <typename FloatType>
+template <typename ProcessContext>
+void BasicRokmanEngine<FloatType>::processMode(const ProcessContext& context) noexcept {
+    if (currentMode < 0)
+        return;
+
+    if (CoefficientBank::isDriven(currentMode))
+        DrivenPath::process(chain, context, profiler);
+    else
+        CleanPath::process(chain, context, profiler);
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::process(juce::AudioBuffer<FloatType>& buffer) {
+    process(buffer, 0, buffer.getNumSamples());
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::process(juce::AudioBuffer<FloatType>& buffer, int startSample, int numSamples) {
+    auto endSample = startSample + numSamples;
+    minimumGain = SIMDType::expand(FloatType(1));
+
+    // Every stage runs over one sub-block before the next stage reads it,
+    // however long the host's buffer is. The sub-blocks sit on a grid that
+    // starts at reset, a buffer that ends partway into one leaves the rest
+    // of it for the next call
+    for (int start = startSample; start < endSample;) {
+        auto numSubBlockSamples = juce::jmin(blockSize - subBlockPosition, endSample - start);
+        processSubBlock(buffer, start, numSubBlockSamples);
+
+        start += numSubBlockSamples;
+        subBlockPosition = (subBlockPosition + numSubBlockSamples) % blockSize;
+    }
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::processSubBlock(juce::AudioBuffer<FloatType>& buffer, int startSample, int numSamples) {
+    if (subBlockPosition == 0)
+        advanceControls();
+
+    auto inputIsSilent = isSilent(buffer, startSample, numSamples);
+
+    if (idle && inputIsSilent) {
+        for (int channel = 0; channel < juce::jmin(numChannels, buffer.getNumChannels()); ++channel)
+            buffer.clear(channel, startSample, numSamples);
+
+        skipIdleBlock(numSamples);
+        return;
+    }
+
+    idle = false;
+
+    // Only compared where a link would save something, so 1x doesn't pay
+    // for a memcmp per sub-block
+    auto& drive = chain.template get<ChainPositions::DRIVE>();
+
+    if (drive.canLinkLanes() && channelsAreIdentical(buffer, startSample, numSamples))
+        identicalSamples = juce::jmin(identicalSamples + numSamples, dualMonoHoldSamples);
+    else
+        identicalSamples = 0;
+
+    drive.setLanesLinked(identicalSamples >= dualMonoHoldSamples);
+
+    interleave(buffer, startSample, numSamples);
+
+    auto block = interleaved.getSubBlock(0, (size_t) numSamples);
+    juce::dsp::ProcessContextReplacing<SIMDType> context(block);
+    processMode(context);
+    applyOutputGain(block);
+    minimumGain = SIMDType::min(minimumGain, chain.template get<ChainPositions::Comp>().getMinimumGain(0));
+
+    deinterleave(buffer, startSample, numSamples);
+
+    if (inputIsSilent && isSilent(buffer, startSample, numSamples))
+        silentSamples = juce::jmin(silentSamples + numSamples, idleHoldSamples);
+    else
+        silentSamples = 0;
+
+    idle = silentSamples >= idleHoldSamples;
+}
+
+template <typename FloatType>
+bool BasicRokmanEngine<FloatType>::isSilent(const juce::AudioBuffer<FloatType>& buffer, int startSample, int numSamples) const {
+    for (int channel = 0; channel < juce::jmin(numChannels, buffer.getNumChannels()); ++channel)
+        if (buffer.getMagnitude(channel, startSample, numSamples) > silenceThreshold)
+            return false;
+
+    return true;
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::skipIdleBlock(int numSamples) noexcept {
+    // Everything the chain holds is below the threshold, so it is left as it
+    // is. Only what runs on time carries on: the chorus LFO and the output
+    // gain, the other controls move in advanceControls
+    chain.template get<ChainPositions::DEL1>().skipLFO((size_t) numSamples);
+    outputGain.skip(numSamples);
+}
+
+template <typename FloatType>
+float BasicRokmanEngine<FloatType>::getGainReductionDecibels(int channel) const {
+    if (! juce::isPositiveAndBelow(channel, getMaximumNumChannels()))
+        return 0.0f;
+
+    return (float) -juce::Decibels::gainToDecibels(minimumGain.get((size_t) channel));
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::advanceControls() noexcept {
+    auto smoothing = driveGain.isSmoothing() || hpfShift.isSmoothing() || toneShift.isSmoothing();
+
+    // The filters take the controls' values at the start of every sub-block
+    // while they glide, and once more after they arrive
+    if (smoothing || filtersBehind) {
+        updateFilters();
+        filtersBehind = smoothing;
+    }
+
+    // A whole sub-block in one step, even when this buffer only has part of
+    // it, so the values don't depend on where the host's blocks end
+    driveGain.skip(blockSize);
+    hpfShift.skip(blockSize);
+    toneShift.skip(blockSize);
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::applyOutputGain(juce::dsp::AudioBlock<SIMDType>& block) noexcept {
+    auto* data = block.getChannelPointer(0);
+    auto numSamples = block.getNumSamples();
+
+    if (outputGain.isSmoothing()) {
+        for (size_t i = 0; i < numSamples; ++i)
+            data[i] = data[i] * (FloatType) outputGain.getNextValue();
+    } else if (outputGain.getTargetValue() != 1.0f) {
+        auto gain = (FloatType) outputGain.getTargetValue();
+
+        for (size_t i = 0; i < numSamples; ++i)
+            data[i] = data[i] * gain;
+    }
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::processStage(int position, juce::AudioBuffer<FloatType>& buffer) {
+    for (int start = 0; start < buffer.getNumSamples(); start += blockSize) {
+        auto numSamples = juce::jmin(blockSize, buffer.getNumSamples() - start);
+
+        interleave(buffer, start, numSamples);
+
+        auto block = interleaved.getSubBlock(0, (size_t) numSamples);
+        juce::dsp::ProcessContextReplacing<SIMDType> context(block);
+
+        switch (position) {
+            case HPF:   StagePath<HPF>::process(chain, context);   break;
+            case Comp:  StagePath<Comp>::process(chain, context);  break;
+            case EQ1:   StagePath<EQ1>::process(chain, context);   break;
+            case DRIVE: StagePath<DRIVE>::process(chain, context); break;
+            case EQ2:   StagePath<EQ2>::process(chain, context);   break;
+            case DEL1:  StagePath<DEL1>::process(chain, context);  break;
+            default: break;
+        }
+
+        deinterleave(buffer, start, numSamples);
+    }
+}
+
+template <typename FloatType>
+bool BasicRokmanEngine<FloatType>::isStageActive(int mode, int position) {
+    if (! juce::isPositiveAndBelow(mode, (int) CoefficientBank::numModes))
+        return false;
+
+    return CoefficientBank::isDriven(mode) ? DrivenPath::contains(position) : CleanPath::contains(position);
+}
+
+template <typename FloatType>
+CoefficientBank::Biquad BasicRokmanEngine<FloatType>::interpolate(const std::array<Biquad, CoefficientBank::tableSize>& table, float octaves) noexcept {
+    auto position = CoefficientBank::getTablePosition(octaves);
+    auto index = juce::jmin((int) position, CoefficientBank::tableSize - 2);
+
+    return CoefficientBank::interpolate(table[(size_t) index], table[(size_t) index + 1], position - (float) index);
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::setSections(Cascade& cascade, const SectionTable& table, int numSections, float octaves, int gainSection, float gain) noexcept {
+    static_assert(CoefficientBank::maxSections <= Cascade::maximumNumSections);
+
+    auto position = CoefficientBank::getTablePosition(octaves);
+    auto index = juce::jmin((int) position, CoefficientBank::tableSize - 2);
+    auto amount = position - (float) index;
+
+    cascade.setNumSections(numSections);
+
+    for (int i = 0; i < numSections; ++i) {
+        auto c = CoefficientBank::interpolate(table[(size_t) index][(size_t) i], table[(size_t) index + 1][(size_t) i], amount);
+
+        // Only the numerator, the poles stay where they are
+        auto g = i == gainSection ? gain : 1.0f;
+        cascade.setSection(i, c[0] * g, c[1] * g, c[2] * g, c[3], c[4]);
+    }
+}
+
+template <typename FloatType>
+bool BasicRokmanEngine<FloatType>::channelsAreIdentical(const juce::AudioBuffer<FloatType>& buffer, int startSample, int numSamples) const {
+    auto channels = juce::jmin(numChannels, buffer.getNumChannels());
+
+    if (channels < 2)
+        return false;
+
+    auto* first = buffer.getReadPointer(0, startSample);
+
+    for (int channel = 1; channel < channels; ++channel)
+        if (std::memcmp(first, buffer.getReadPointer(channel, startSample), (size_t) numSamples * sizeof(FloatType)) != 0)
+            return false;
+
+    return true;
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::interleave(const juce::AudioBuffer<FloatType>& buffer, int startSample, int numSamples) {
+    constexpr auto numLanes = SampleTraits<SIMDType>::numLanes;
+
+    auto* destination = reinterpret_cast<FloatType*>(interleaved.getChannelPointer(0));
+    auto channels = (size_t) juce::jmin(numChannels, buffer.getNumChannels());
+
+    for (size_t lane = 0; lane < numLanes; ++lane) {
+        if (lane < channels) {
+            auto* source = buffer.getReadPointer((int) lane, startSample);
+
+            for (int i = 0; i < numSamples; ++i)
+                destination[(size_t) i * numLanes + lane] = source[i];
+        } else {
+            for (int i = 0; i < numSamples; ++i)
+                destination[(size_t) i * numLanes + lane] = FloatType(0);
+        }
+    }
+}
+
+template <typename FloatType>
+void BasicRokmanEngine<FloatType>::deinterleave(juce::AudioBuffer<FloatType>& buffer, int startSample, int numSamples) const {
+    constexpr auto numLanes = SampleTraits<SIMDType>::numLanes;
+
+    auto* source = reinterpret_cast<const FloatType*>(interleaved.getChannelPointer(0));
+    auto channels = (size_t) juce::jmin(numChannels, buffer.getNumChannels());
+
+    for (size_t lane = 0; lane < channels; ++lane) {
+        auto* destination = buffer.getWritePointer((int) lane, startSample);
+
+        for (int i = 0; i < numSamples; ++i)
+            destination[i] = source[(size_t) i * numLanes + lane];
+    }
+}
+
+template class BasicRokmanEngine<float>;
+template class BasicRokmanEngine<double>;
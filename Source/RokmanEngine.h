@@ -0,0 +1,278 @@
+/*
+  ==============================================================================
+
+    RokmanEngine.h
+
+    The Rokman signal chain for up to SIMDRegister<FloatType>::size()
+    channels. Channels are interleaved into the lanes of a SIMD register so
+    that every stage runs once per sample for all of them.
+
+    RokmanEngine is the float chain, RokmanEngineDouble the one for hosts
+    that process in double. Both read the same CoefficientBank, which keeps
+    its coefficients in double; the float engine rounds them as it loads
+    them. Double has half the lanes, two on SSE and NEON, which is still
+    enough for a stereo bus.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "ChorusEcho.h"
+#include "CoefficientBank.h"
+#include "RokmanDSP.h"
+#include "Shapers.h"
+#include "StageProfiler.h"
+
+template <typename FloatType>
+class BasicRokmanEngine {
+public:
+    // Allocates, call it from prepareToPlay only. The chain is sized for
+    // one sub-block, or for maximumBlockSize if the host never sends more
+    void prepare(double sampleRate, int maximumBlockSize, int numChannels);
+    void reset();
+
+    // Every buffer goes through the chain in sub-blocks of this many
+    // samples, whatever size the host sends, so each one is still in L1 when
+    // the next stage reads it. The controls move the filters at sub-block
+    // boundaries. Takes effect at the next prepare
+    void setSubBlockSize(int numSamples);
+    int getSubBlockSize() const { return subBlockSize; }
+
+    // Real-time safe, only copies coefficients and picks the mode's path
+    void setMode(int mode);
+    int getMode() const { return currentMode; }
+
+    // DELAY 1, real-time safe, both fade in and out
+    void setChorusEcho(bool chorus, bool echo);
+
+    // Whether the chorus is added to (1) or subtracted from (-1) a channel.
+    // Left adds and right subtracts by default, the X100's stereo spread;
+    // independent tracks want 1 everywhere. Real-time safe, kept across
+    // prepare
+    void setChorusSign(int channel, FloatType sign);
+
+    // Continuous controls, real-time safe. They glide over smoothingTime and
+    // reach the filters once per sub-block, from the bank's tables
+    void setDrive(float decibels);
+    void setOutputLevel(float decibels);
+    void setHPFShift(float octaves);
+    void setTone(float octaves);
+
+    // Everything at once, the mode switches without a crossfade. ModeSwitcher
+    // is what the plugin uses
+    void setChainSettings(const ChainSettings& settings);
+
+    // Renders that start partway into a file: puts what depends on the time
+    // since reset (the chorus LFO) where a render from the start has it.
+    // Call it after reset
+    void setStartPosition(juce::int64 numSamples);
+
+    // How long the output keeps going once the input stops, latency aside
+    static double getTailLengthSeconds(const ChainSettings& settings);
+
+    // True while the input and everything the chain still holds are below
+    // silenceThreshold. Blocks are then only cleared, the first one with
+    // signal is processed as usual
+    bool isIdle() const { return idle; }
+
+    // Takes over the chorus and echo of an engine prepared the same way, so
+    // the repeats carry on across a Mode switch, and resets everything else,
+    // in place of reset. The echo history comes over in copyDelayState, a
+    // piece before every block both engines process, so no single block
+    // copies it all. True once it is complete
+    void startDelayStateCopy(const BasicRokmanEngine& source);
+    bool copyDelayState(const BasicRokmanEngine& source, int numSamples, int samplesToDeadline);
+
+    // factorIndex: 0 = 1x, 1 = 2x, 2 = 4x, 3 = 8x
+    // filterType: 0 = polyphase IIR, 1 = FIR equiripple
+    void setOversampling(int factorIndex, int filterType);
+
+    // The oversampling filters and the ADAA delay, rounded to a whole
+    // sample. First order ADAA delays by half a sample at the rate it runs
+    // at, so with it on the rounding leaves the output up to half a sample
+    // off: it is only compensated to the nearest sample, not exactly
+    int getLatencySamples() const;
+
+    // 0 = hard clip, 1 = tanh, 2 = diode pair, 3 = asymmetric, 4 = circuit.
+    // The circuit curve also swaps CF 17 for the X100's EQ in the driven modes
+    void setShaperCurve(int curve);
+
+    // 0 = off, 1 = first order, 2 = second order ADAA. Only the hard clip
+    // and tanh curves use it, at whatever oversampling is set
+    void setAntialiasing(int order);
+
+    // Processes the first getNumChannels() channels of the buffer in place
+    void process(juce::AudioBuffer<FloatType>& buffer);
+    void process(juce::AudioBuffer<FloatType>& buffer, int startSample, int numSamples);
+
+    // For benchmarks: runs only the given ChainPositions stage (or nothing
+    // for -1) over the buffer, in sub-blocks like process, interleaving
+    // included
+    void processStage(int position, juce::AudioBuffer<FloatType>& buffer);
+    static bool isStageActive(int mode, int position);
+
+    // True while every channel has been bit-identical for a while and only
+    // one of them goes through the oversampled drive section
+    bool isDualMono() const { return chain.template get<ChainPositions::DRIVE>().areLanesLinked(); }
+
+    // How far the compressor pulled the channel down during the last process
+    // call, in dB (0 or more). Audio thread only, ModeSwitcher publishes it
+    float getGainReductionDecibels(int channel) const;
+
+    // Sections 0 to numChainPositions - 1 get one measurement per stage and
+    // sub-block. Does nothing unless ROKMAN_PROFILING is on
+    void setProfiler(StageProfiler* newProfiler) { profiler = newProfiler; }
+
+    int getNumChannels() const { return numChannels; }
+    static constexpr int getMaximumNumChannels() { return (int) SampleTraits<SIMDType>::numLanes; }
+
+    enum ChainPositions {
+        HPF,
+        Comp,
+        EQ1,
+        DRIVE,
+        EQ2,
+        DEL1
+    };
+
+    static constexpr int numChainPositions = DEL1 + 1;
+
+    static constexpr int defaultSubBlockSize = 64;
+    static constexpr int minimumSubBlockSize = 16, maximumSubBlockSize = 1024;
+
+    static constexpr double smoothingTime = 0.05;
+
+    // -120 dBFS
+    static constexpr FloatType silenceThreshold = FloatType(1.0e-6);
+
+private:
+    using SIMDType = juce::dsp::SIMDRegister<FloatType>;
+
+    using Filter = IIRStage<SIMDType>;
+    using Compressor = CompressorStage<SIMDType>;
+
+    // HBEQ, MBPF, LBEQ and CF, as many of them in a row as a mode has, see
+    // CoefficientBank.h
+    using Cascade = BiquadCascade<SIMDType, 4>;
+    using DelayLine = ChorusEchoStage<SIMDType>;
+
+    // AD 16, the only nonlinear part of the chain and the only one that runs
+    // oversampled. OPAMP and OPAMP2 live in the EQ1 and EQ2 coefficients
+    using DriveSection = OversampledStage<SIMDType, ShaperStage>;
+
+    // Holds every stage, the modes below pick which of them run
+    using StereoChain = juce::dsp::ProcessorChain<Filter, Compressor, Cascade, DriveSection, Cascade, DelayLine>;
+
+    // The stages a mode runs, in order. Each mode is its own type, so a
+    // stage the mode doesn't use is never touched, not even to test a
+    // bypass flag
+    template <ChainPositions... Positions>
+    struct StagePath {
+        template <typename ProcessContext>
+        static void process(StereoChain& stages, const ProcessContext& context, StageProfiler* profiler = nullptr) noexcept {
+            (processStage<Positions>(stages, context, profiler), ...);
+        }
+
+        template <ChainPositions Position, typename ProcessContext>
+        static void processStage(StereoChain& stages, const ProcessContext& context, StageProfiler* profiler) noexcept {
+            juce::ignoreUnused(profiler);
+            ROKMAN_PROFILE_SCOPE(profiler, Position, (int) context.getOutputBlock().getNumSamples());
+            stages.template get<Position>().process(context);
+        }
+
+        static constexpr bool contains(int position) noexcept {
+            return ((position == Positions) || ...);
+        }
+    };
+
+    // Dist and Edge, and Cln1 and Cln2, only differ in what EQ1 and EQ2 hold
+    using DrivenPath = StagePath<HPF, Comp, EQ1, DRIVE, EQ2, DEL1>;
+    using CleanPath = StagePath<HPF, Comp, EQ1, DEL1>;
+
+    StereoChain chain;
+    CoefficientBank coefficientBank;
+    StageProfiler* profiler {nullptr};
+
+    // Drive and output as gains
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> driveGain {1.0f}, outputGain {1.0f};
+    juce::SmoothedValue<float> hpfShift, toneShift;
+
+    juce::HeapBlock<char> interleavedBlockData;
+    juce::dsp::AudioBlock<SIMDType> interleaved;
+
+    // Lowest compressor gain per lane over the last process call
+    SIMDType minimumGain {SIMDType::expand(FloatType(1))};
+
+    // What setSubBlockSize asked for, and what prepare made of it
+    int subBlockSize {defaultSubBlockSize};
+    int blockSize {1};
+
+    // Samples into the current sub-block, non-zero when the last buffer
+    // ended partway into one
+    int subBlockPosition {0};
+
+    // The last update of the filters was made while the controls were still
+    // gliding, the next boundary brings them to the final values
+    bool filtersBehind {false};
+
+    int numChannels {0};
+    int currentMode {-1};
+
+    // The Circuit curve is set, EQ2 comes from the bank's circuitEQ2
+    bool circuitTone {false};
+
+    // Dual mono detection. Channels have to match for dualMonoHoldSamples
+    // before they are linked, a single differing sample unlinks them
+    int identicalSamples {0};
+    int dualMonoHoldSamples {0};
+
+    bool channelsAreIdentical(const juce::AudioBuffer<FloatType>& buffer, int startSample, int numSamples) const;
+
+    // Input and output have to stay under silenceThreshold for
+    // idleHoldSamples, long enough for the delay lines to have played out
+    // everything they held, before processing stops
+    int silentSamples {0};
+    int idleHoldSamples {0};
+    bool idle {false};
+
+    bool isSilent(const juce::AudioBuffer<FloatType>& buffer, int startSample, int numSamples) const;
+
+    // reset, the chorus and echo buffers aside
+    void resetAllButDelays() noexcept;
+
+    // What processing would have moved on during a skipped block
+    void skipIdleBlock(int numSamples) noexcept;
+
+    using Biquad = CoefficientBank::Biquad;
+    using SectionTable = std::array<std::array<Biquad, CoefficientBank::maxSections>, CoefficientBank::tableSize>;
+
+    // Sets the mode's filters from the current control values
+    void updateFilters() noexcept;
+
+    static Biquad interpolate(const std::array<Biquad, CoefficientBank::tableSize>& table, float octaves) noexcept;
+    static void setSections(Cascade& cascade, const SectionTable& table, int numSections, float octaves, int gainSection, float gain) noexcept;
+
+    // Interleaving, the chain, the output gain and the idle and dual mono
+    // bookkeeping for one sub-block, or the part of it in this buffer
+    void processSubBlock(juce::AudioBuffer<FloatType>& buffer, int startSample, int numSamples);
+
+    // At every sub-block boundary, moves the controls on and the filters
+    // with them
+    void advanceControls() noexcept;
+    void applyOutputGain(juce::dsp::AudioBlock<SIMDType>& block) noexcept;
+
+    void interleave(const juce::AudioBuffer<FloatType>& buffer, int startSample, int numSamples);
+    void deinterleave(juce::AudioBuffer<FloatType>& buffer, int startSample, int numSamples) const;
+
+    template <typename ProcessContext>
+    void processMode(const ProcessContext& context) noexcept;
+};
+
+using RokmanEngine = BasicRokmanEngine<float>;
+using RokmanEngineDouble = BasicRokmanEngine<double>;
+
+extern template class BasicRokmanEngine<float>;
+extern template class BasicRokmanEngine<double>;
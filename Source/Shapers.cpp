@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    Shapers.cpp
+
+  ==============================================================================
+*/
+
+#include "Shapers.h"
+
+namespace ShaperCurves {
+
+namespace {
+
+// AD 16 parts. 1N914-class diodes, two in series each way
+constexpr double r1 = 10.0e3, rf = 10.0e3;
+constexpr double saturationCurrent = 2.52e-9, emissionCoefficient = 1.752, thermalVoltage = 0.02585;
+constexpr double diodesPerString = 2.0;
+
+constexpr double diodeVoltage = diodesPerString * emissionCoefficient * thermalVoltage;
+
+// Current out of the summing node for an output y, and its derivative
+double feedbackCurrent(double y) { return y / rf + 2.0 * saturationCurrent * std::sinh(y / diodeVoltage); }
+double feedbackConductance(double y) { return 1.0 / rf + 2.0 * saturationCurrent * std::cosh(y / diodeVoltage) / diodeVoltage; }
+
+// The output for an input u >= 0. The current is monotonic in y, so Newton
+// is kept inside a shrinking bracket and falls back to bisection when a step
+// leaves it
+double solve(double u, double guess) {
+    auto target = u / r1;
+    auto low = 0.0, high = juce::jmax(u * rf / r1, 1.0e-9);
+    auto y = juce::jlimit(low, high, guess);
+
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        auto error = feedbackCurrent(y) - target;
+
+        if (error > 0.0)
+            high = y;
+        else
+            low = y;
+
+        auto next = y - error / feedbackConductance(y);
+
+        if (! (next > low && next < high))
+            next = 0.5 * (low + high);
+
+        if (std::abs(next - y) < 1.0e-12)
+            return next;
+
+        y = next;
+    }
+
+    return y;
+}
+
+} // namespace
+
+DiodeClipperTable::DiodeClipperTable() {
+    auto fill = [](auto& points, double start, double step) {
+        auto y = 0.0;
+
+        for (size_t i = 0; i < points.size(); ++i) {
+            auto u = start + step * (double) i;
+            y = solve(u, y);
+
+            // dy/du = (1 / R1) / (d feedbackCurrent / dy)
+            points[i] = {(float) y, (float) (1.0 / (r1 * feedbackConductance(y)))};
+        }
+    };
+
+    fill(fine, 0.0, fineEnd / fineSize);
+    fill(coarse, fineEnd, (maximumInput - fineEnd) / coarseSize);
+
+    tailValue = coarse.back().value;
+    tailVoltage = (float) diodeVoltage;
+    tailOffset = (float) (r1 / rf * (double) tailValue);
+}
+
+const DiodeClipperTable diodeClipperTable;
+
+double dilogarithm(double x) noexcept {
+    jassert(x >= -1.0 && x <= 0.0);
+
+    // Landen's identity, Li2(x) = -Li2(w) - ln(1 - x)^2 / 2 with
+    // w = x / (x - 1) in [0, 1/2], and Li2(w) from its Bernoulli series in
+    // z = -ln(1 - w) = ln(1 - x) <= ln 2, sum of B_k z^(k + 1) / (k + 1)!
+    static constexpr double coefficients[] = {
+        1.0 / 36.0, -1.0 / 3600.0, 1.0 / 211680.0, -1.0 / 10886400.0, 1.0 / 526901760.0,
+        -4.064761645144226e-11, 8.921691020456453e-13, -1.993929586072108e-14
+    };
+
+    auto z = std::log1p(-x);
+    auto z2 = z * z;
+    auto series = 0.0;
+
+    for (auto i = std::size(coefficients); i > 0; --i)
+        series = series * z2 + coefficients[i - 1];
+
+    auto li2w = z - 0.25 * z2 + z * z2 * series;
+    return -li2w - 0.5 * z2;
+}
+
+} // namespace ShaperCurves
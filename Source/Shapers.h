@@ -0,0 +1,467 @@
+/*
+  ==============================================================================
+
+    Shapers.h
+
+    Transfer curves for the AD stage as compile-time policies. Each curve is
+    a struct with a static apply(u, ceiling) taking the already driven
+    signal, written with SampleTraits so the same code runs on float, double
+    and SIMD registers, and gets inlined into the block loop of ShaperStage.
+
+    Circuit is the one curve taken from the schematic rather than written
+    down: the diode feedback equation has no closed form, so it is solved
+    once at load time into a table and only read back per sample. The
+    engine pairs it with the X100's own EQ after the drive, which is linear
+    and lives in CoefficientBank. The compressor's gain element, the JFET
+    Q101, is not modelled: its bias resistors are selected per unit at the
+    factory, so the schematic gives no operating point to solve it at.
+
+    HardClip and Tanh also have their first and second antiderivatives, for
+    antiderivative antialiasing (ADAA): the output is the curve averaged
+    over the straight line between neighbouring inputs (first order) or
+    weighted by a triangle over the last three (second order), which takes
+    out most of the aliasing without oversampling. It delays the signal by
+    half a sample and one sample respectively, which the stage reports as
+    its latency. The host only takes whole samples, so the first order's
+    half sample is compensated to the nearest one and no closer; making it
+    whole would take a fractional delay, which dulls the top like the one
+    in ChorusEcho.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "RokmanDSP.h"
+
+namespace ShaperCurves {
+
+//==============================================================================
+// [7/6] Pade approximant of tanh (Lambert's continued fraction), with the
+// input clamped to +-4.97 where it reaches 1. Max absolute error against
+// std::tanh is below 1.0e-4 over the whole real line (9.6e-5 at |x| = 4.97),
+// and it is odd and monotonic, so it never overshoots +-1.
+template <typename SampleType>
+inline SampleType fastTanh(SampleType x) noexcept {
+    using Traits = SampleTraits<SampleType>;
+    using NumericType = typename Traits::NumericType;
+
+    x = Traits::clip(x, Traits::broadcast(NumericType(-4.97)), Traits::broadcast(NumericType(4.97)));
+    auto x2 = x * x;
+
+    auto numerator = x * (Traits::broadcast(NumericType(135135))
+                          + x2 * (Traits::broadcast(NumericType(17325))
+                                  + x2 * (Traits::broadcast(NumericType(378)) + x2)));
+    auto denominator = Traits::broadcast(NumericType(135135))
+                     + x2 * (Traits::broadcast(NumericType(62370))
+                             + x2 * (Traits::broadcast(NumericType(3150)) + x2 * NumericType(28)));
+
+    return Traits::clip(Traits::divide(numerator, denominator), Traits::broadcast(NumericType(-1)), Traits::broadcast(NumericType(1)));
+}
+
+//==============================================================================
+// jlimit(-ceiling, ceiling, u), the original AD 16
+struct HardClip {
+    template <typename SampleType>
+    static SampleType apply(SampleType u, SampleType ceiling) noexcept {
+        return SampleTraits<SampleType>::clip(u, SampleType() - ceiling, ceiling);
+    }
+
+    // For ADAA, in double since they are differenced
+    static double exact(double u, double ceiling) noexcept { return juce::jlimit(-ceiling, ceiling, u); }
+
+    static double antiderivative1(double u, double ceiling) noexcept {
+        auto a = std::abs(u);
+        return a <= ceiling ? 0.5 * u * u : ceiling * a - 0.5 * ceiling * ceiling;
+    }
+
+    static double antiderivative2(double u, double ceiling) noexcept {
+        auto a = std::abs(u);
+        auto f = a <= ceiling ? a * a * a / 6.0 : ceiling * (0.5 * a * a - 0.5 * ceiling * a + ceiling * ceiling / 6.0);
+        return u < 0.0 ? -f : f;
+    }
+};
+
+// Li2(x) for -1 <= x <= 0, to double precision
+double dilogarithm(double x) noexcept;
+
+// tanh(u), the curve that was left commented out in the original AD 16.
+// Saturates at +-1 whatever the ceiling
+struct Tanh {
+    template <typename SampleType>
+    static SampleType apply(SampleType u, SampleType) noexcept {
+        return fastTanh(u);
+    }
+
+    static double exact(double u, double) noexcept { return std::tanh(u); }
+
+    static constexpr double ln2 = 0.69314718055994530942;
+
+    // log(cosh(u)), written so that it doesn't overflow
+    static double antiderivative1(double u, double) noexcept {
+        auto a = std::abs(u);
+        return a + std::log1p(std::exp(-2.0 * a)) - ln2;
+    }
+
+    static double antiderivative2(double u, double) noexcept {
+        constexpr auto pi2Over12 = juce::MathConstants<double>::pi * juce::MathConstants<double>::pi / 12.0;
+
+        auto a = std::abs(u);
+        auto f = 0.5 * a * a - ln2 * a + 0.5 * (dilogarithm(-std::exp(-2.0 * a)) + pi2Over12);
+        return u < 0.0 ? -f : f;
+    }
+};
+
+// Soft knee of a pair of antiparallel diodes, unity slope at zero and
+// approaching +-ceiling: u / (1 + |u| / ceiling)
+struct DiodePair {
+    template <typename SampleType>
+    static SampleType apply(SampleType u, SampleType ceiling) noexcept {
+        using Traits = SampleTraits<SampleType>;
+        return Traits::divide(u * ceiling, ceiling + Traits::abs(u));
+    }
+};
+
+// Hard clip on the positive side, a softer and lower diode knee on the
+// negative side, which adds even harmonics
+struct Asymmetric {
+    template <typename SampleType>
+    static SampleType apply(SampleType u, SampleType ceiling) noexcept {
+        using Traits = SampleTraits<SampleType>;
+        using NumericType = typename Traits::NumericType;
+
+        auto negativeCeiling = ceiling * NumericType(0.7);
+        auto positive = Traits::min(u, ceiling);
+        auto negative = Traits::divide(u * negativeCeiling, negativeCeiling + Traits::abs(u));
+
+        return Traits::selectGreater(u, SampleType(), positive, negative);
+    }
+};
+
+//==============================================================================
+// AD 16 as the X100 builds it: an op-amp with R1 at the input and, in the
+// feedback path, Rf across two strings of two silicon diodes back to back.
+// With the op-amp ideal the output y for an input u is the root of
+//
+//     u / R1 = y / Rf + 2 Is sinh(y / (N n Vt))
+//
+// solved by Newton's method for a grid of inputs, with dy/du from implicit
+// differentiation, and read back by cubic Hermite interpolation. Fine steps
+// cover the knee, coarse ones the logarithmic tail; the curve is odd, so
+// only u >= 0 is stored. Within 1.0e-6 V of the exact root everywhere
+class DiodeClipperTable {
+public:
+    DiodeClipperTable();
+
+    // Volts in, volts out. Past maximumInput nearly all of the current goes
+    // through the diodes, so the output is their logarithm from the end of
+    // the table on, which holds for any input the chain can give it. NaN
+    // gives 0
+    float operator()(float u) const noexcept {
+        auto x = std::abs(u);
+
+        if (! (x < maximumInput)) {
+            if (std::isnan(x))
+                return 0.0f;
+
+            x = std::min(x, std::numeric_limits<float>::max());
+            auto y = tailValue + tailVoltage * std::log((x - tailOffset) / (maximumInput - tailOffset));
+            return u < 0.0f ? -y : y;
+        }
+
+        const Point* points;
+        float scale;
+        int last;
+
+        if (x < fineEnd) {
+            points = fine.data();
+            scale = fineSize / fineEnd;
+            last = fineSize - 1;
+        } else {
+            points = coarse.data();
+            scale = coarseSize / (maximumInput - fineEnd);
+            last = coarseSize - 1;
+            x = std::min(x, maximumInput) - fineEnd;
+        }
+
+        auto position = x * scale;
+        auto index = std::min((int) position, last);
+        auto t = position - (float) index;
+
+        const auto& a = points[index];
+        const auto& b = points[index + 1];
+        auto h = 1.0f / scale;
+
+        auto t2 = t * t, t3 = t2 * t;
+        auto y = (2.0f * t3 - 3.0f * t2 + 1.0f) * a.value + (t3 - 2.0f * t2 + t) * h * a.slope
+               + (3.0f * t2 - 2.0f * t3) * b.value + (t3 - t2) * h * b.slope;
+
+        return u < 0.0f ? -y : y;
+    }
+
+    // The level the original AD 16 clipped at, the circuit gets there at
+    // about 140 V of input
+    static constexpr float nominalCeiling = 1.4f;
+
+private:
+    static constexpr int fineSize = 1024, coarseSize = 1024;
+    static constexpr float fineEnd = 4.0f, maximumInput = 256.0f;
+
+    struct Point {
+        float value, slope;
+    };
+
+    std::array<Point, fineSize + 1> fine;
+    std::array<Point, coarseSize + 1> coarse;
+
+    // Past maximumInput: u / R1 - y / Rf = Is exp(y / (N n Vt)), with y / Rf
+    // held at its value at the end of the table, where it is a tiny part of
+    // the current. tailOffset is that y scaled to the input, R1 / Rf y
+    float tailValue {0.0f}, tailVoltage {0.0f}, tailOffset {0.0f};
+};
+
+// Built during static initialisation, before any engine exists
+extern const DiodeClipperTable diodeClipperTable;
+
+// DiodeClipperTable scaled so that its nominal ceiling lands on ceiling
+struct Circuit {
+    template <typename SampleType>
+    static SampleType apply(SampleType u, SampleType ceiling) noexcept {
+        using Traits = SampleTraits<SampleType>;
+        using NumericType = typename Traits::NumericType;
+
+        constexpr auto nominal = static_cast<NumericType>(DiodeClipperTable::nominalCeiling);
+        auto scaled = Traits::divide(u * nominal, ceiling);
+
+        auto y = Traits::map(scaled, [](NumericType v) {
+            return static_cast<NumericType>(diodeClipperTable(static_cast<float>(v)));
+        });
+
+        return y * (ceiling * (NumericType(1) / nominal));
+    }
+};
+
+} // namespace ShaperCurves
+
+//==============================================================================
+enum class ShaperCurve {
+    HardClip,
+    Tanh,
+    DiodePair,
+    Asymmetric,
+    Circuit
+};
+
+// Only HardClip and Tanh have it, the other curves ignore it
+enum class ShaperAntialiasing {
+    Off,
+    FirstOrder,
+    SecondOrder
+};
+
+// AD 16: curve(drive * x). The curve is picked once per block, the per
+// sample loop is specialised for each curve
+template <typename SampleType>
+class ShaperStage {
+public:
+    using NumericType = typename SampleTraits<SampleType>::NumericType;
+    using Curve = ShaperCurve;
+    using Antialiasing = ShaperAntialiasing;
+
+    void setCurve(Curve newCurve) noexcept { curve = newCurve; }
+    Curve getCurve() const noexcept { return curve; }
+
+    void setAntialiasing(Antialiasing newAntialiasing) noexcept { antialiasing = newAntialiasing; }
+    Antialiasing getAntialiasing() const noexcept { return antialiasing; }
+
+    // The delay ADAA adds, in samples at the rate the stage runs at. Half a
+    // sample for the first order, which callers round
+    NumericType getLatencyInSamples() const noexcept {
+        if (curve != Curve::HardClip && curve != Curve::Tanh)
+            return NumericType(0);
+
+        switch (antialiasing) {
+            case Antialiasing::FirstOrder:  return NumericType(0.5);
+            case Antialiasing::SecondOrder: return NumericType(1);
+            case Antialiasing::Off:         break;
+        }
+
+        return NumericType(0);
+    }
+
+    void setDrive(NumericType newDrive) noexcept { drive = SampleTraits<SampleType>::broadcast(newDrive); }
+    void setCeiling(NumericType newCeiling) noexcept { ceiling = SampleTraits<SampleType>::broadcast(newCeiling); }
+
+    void prepare(const juce::dsp::ProcessSpec& spec) {
+        history.resize(spec.numChannels * SampleTraits<SampleType>::numLanes);
+        reset();
+    }
+
+    void reset() noexcept {
+        for (auto& lane : history)
+            lane = {};
+    }
+
+    template <typename ProcessContext>
+    void process(const ProcessContext& context) noexcept {
+        switch (curve) {
+            case Curve::HardClip:   processCurve<ShaperCurves::HardClip>(context);   break;
+            case Curve::Tanh:       processCurve<ShaperCurves::Tanh>(context);       break;
+            case Curve::DiodePair:  processCurve<ShaperCurves::DiodePair>(context);  break;
+            case Curve::Asymmetric: processCurve<ShaperCurves::Asymmetric>(context); break;
+            case Curve::Circuit:    processCurve<ShaperCurves::Circuit>(context);    break;
+        }
+    }
+
+private:
+    // Inputs closer than this, after the drive, are treated as equal
+    static constexpr double tolerance = 1.0e-3;
+
+    // ADAA works through a block in chunks of this many samples per lane
+    static constexpr size_t chunkSize = 256;
+
+    // The last two driven inputs of a lane, x1 the newer
+    struct LaneHistory {
+        double x1 {0.0}, x2 {0.0};
+    };
+
+    template <typename CurveType, typename ProcessContext>
+    void processCurve(const ProcessContext& context) noexcept {
+        if constexpr (requires { CurveType::antiderivative2(0.0, 0.0); }) {
+            if (antialiasing != Antialiasing::Off) {
+                processAntialiased<CurveType>(context);
+                return;
+            }
+        }
+
+        processWith<CurveType>(context);
+    }
+
+    template <typename CurveType, typename ProcessContext>
+    void processWith(const ProcessContext& context) noexcept {
+        processChannels(context, [this](size_t, const SampleType* input, SampleType* output, size_t numSamples) {
+            const auto g = drive;
+            const auto c = ceiling;
+
+            for (size_t i = 0; i < numSamples; ++i)
+                output[i] = CurveType::apply(g * input[i], c);
+        });
+    }
+
+    // Lane by lane, each in double. The passes over a chunk are plain loops
+    // over arrays; only the rare nearly equal inputs take a branch
+    template <typename CurveType, typename ProcessContext>
+    void processAntialiased(const ProcessContext& context) noexcept {
+        using Traits = SampleTraits<SampleType>;
+        constexpr auto numLanes = Traits::numLanes;
+
+        processChannels(context, [this](size_t channel, const SampleType* input, SampleType* output, size_t numSamples) {
+            // A SIMD register holds one sample of every lane
+            auto* in = reinterpret_cast<const NumericType*>(input);
+            auto* out = reinterpret_cast<NumericType*>(output);
+
+            for (size_t lane = 0; lane < numLanes; ++lane) {
+                auto& lastInputs = history[channel * numLanes + lane];
+                auto g = (double) Traits::getLane(drive, lane);
+                auto c = (double) Traits::getLane(ceiling, lane);
+
+                for (size_t start = 0; start < numSamples; start += chunkSize) {
+                    auto n = juce::jmin(chunkSize, numSamples - start);
+                    auto offset = start * numLanes + lane;
+
+                    if (antialiasing == Antialiasing::SecondOrder)
+                        processSecondOrder<CurveType>(lastInputs, in + offset, out + offset, numLanes, n, g, c);
+                    else
+                        processFirstOrder<CurveType>(lastInputs, in + offset, out + offset, numLanes, n, g, c);
+                }
+            }
+        });
+    }
+
+    // y[n] = (F1(x[n]) - F1(x[n-1])) / (x[n] - x[n-1])
+    template <typename CurveType>
+    void processFirstOrder(LaneHistory& lastInputs, const NumericType* input, NumericType* output, size_t stride, size_t n, double g, double c) noexcept {
+        x[0] = lastInputs.x1;
+
+        for (size_t i = 0; i < n; ++i)
+            x[i + 1] = g * (double) input[i * stride];
+
+        for (size_t i = 0; i <= n; ++i)
+            f[i] = CurveType::antiderivative1(x[i], c);
+
+        for (size_t i = 0; i < n; ++i) {
+            auto dx = x[i + 1] - x[i];
+            y[i] = (f[i + 1] - f[i]) / (std::abs(dx) > tolerance ? dx : 1.0);
+        }
+
+        // Nearly equal neighbours: the curve at their midpoint
+        for (size_t i = 0; i < n; ++i)
+            if (std::abs(x[i + 1] - x[i]) <= tolerance)
+                y[i] = CurveType::exact(0.5 * (x[i] + x[i + 1]), c);
+
+        for (size_t i = 0; i < n; ++i)
+            output[i * stride] = static_cast<NumericType>(y[i]);
+
+        lastInputs = {x[n], x[n - 1]};
+    }
+
+    // y[n] = 2 / (x[n] - x[n-2]) * (D[n] - D[n-1]), where D[n] is the
+    // first order divided difference of F2 between x[n] and x[n-1]
+    template <typename CurveType>
+    void processSecondOrder(LaneHistory& lastInputs, const NumericType* input, NumericType* output, size_t stride, size_t n, double g, double c) noexcept {
+        x[0] = lastInputs.x2;
+        x[1] = lastInputs.x1;
+
+        for (size_t i = 0; i < n; ++i)
+            x[i + 2] = g * (double) input[i * stride];
+
+        for (size_t i = 0; i < n + 2; ++i)
+            f[i] = CurveType::antiderivative2(x[i], c);
+
+        // d[i] between x[i] and x[i + 1]
+        for (size_t i = 0; i <= n; ++i) {
+            auto dx = x[i + 1] - x[i];
+            d[i] = (f[i + 1] - f[i]) / (std::abs(dx) > tolerance ? dx : 1.0);
+        }
+
+        for (size_t i = 0; i <= n; ++i)
+            if (std::abs(x[i + 1] - x[i]) <= tolerance)
+                d[i] = CurveType::antiderivative1(0.5 * (x[i] + x[i + 1]), c);
+
+        for (size_t i = 0; i < n; ++i) {
+            auto span = x[i + 2] - x[i];
+            y[i] = 2.0 * (d[i + 1] - d[i]) / (std::abs(span) > tolerance ? span : 1.0);
+        }
+
+        // x[n] close to x[n-2]: the same average, expanded around their midpoint
+        for (size_t i = 0; i < n; ++i) {
+            if (std::abs(x[i + 2] - x[i]) > tolerance)
+                continue;
+
+            auto middle = 0.5 * (x[i + 2] + x[i]);
+            auto delta = middle - x[i + 1];
+
+            if (std::abs(delta) <= tolerance)
+                y[i] = CurveType::exact(0.5 * (middle + x[i + 1]), c);
+            else
+                y[i] = 2.0 / delta * (CurveType::antiderivative1(middle, c)
+                                      + (CurveType::antiderivative2(x[i + 1], c) - CurveType::antiderivative2(middle, c)) / delta);
+        }
+
+        for (size_t i = 0; i < n; ++i)
+            output[i * stride] = static_cast<NumericType>(y[i]);
+
+        lastInputs = {x[n + 1], x[n]};
+    }
+
+    Curve curve {Curve::HardClip};
+    Antialiasing antialiasing {Antialiasing::Off};
+    SampleType drive {SampleTraits<SampleType>::broadcast(1)};
+    SampleType ceiling {SampleTraits<SampleType>::broadcast(1)};
+
+    std::vector<LaneHistory> history;
+
+    // Scratch for one chunk of one lane
+    std::array<double, chunkSize + 2> x, f, d, y;
+};
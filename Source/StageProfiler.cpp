@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    StageProfiler.cpp
+
+  ==============================================================================
+*/
+
+#include "StageProfiler.h"
+
+StageProfiler::StageProfiler(const juce::StringArray& sectionNames)
+    : juce::Thread("Rokman profiler"), names(sectionNames) {
+    measurements.resize((size_t) fifo.getTotalSize());
+    windows.resize((size_t) names.size());
+
+    for (auto& window : windows) {
+        window.nanoseconds.resize(windowSize);
+        window.loads.resize(windowSize);
+    }
+
+    lastSummaryTime = juce::Time::getMillisecondCounterHiRes();
+    startThread();
+}
+
+StageProfiler::~StageProfiler() {
+    stopThread(1000);
+}
+
+void StageProfiler::setContext(const juce::String& description, double newSampleRate) {
+    const juce::ScopedLock sl(lock);
+
+    context = description;
+    sampleRate = newSampleRate;
+
+    // Old numbers were measured with other settings
+    for (auto& window : windows)
+        window.next = window.count = 0;
+}
+
+void StageProfiler::setCSVFile(const juce::File& file) {
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+
+    if (! stream->openedOk())
+        stream.reset();
+    else if (stream->getPosition() == 0)
+        stream->writeText("time_ms,context,section,samples,ns\n", false, false, nullptr);
+
+    const juce::ScopedLock sl(lock);
+    csv = std::move(stream);
+}
+
+StageProfiler::Statistics StageProfiler::getStatistics(int section) const {
+    Statistics statistics;
+    std::vector<double> sorted;
+    double maxLoad = 0.0;
+
+    {
+        const juce::ScopedLock sl(lock);
+
+        if (! juce::isPositiveAndBelow(section, (int) windows.size()))
+            return statistics;
+
+        auto& window = windows[(size_t) section];
+        sorted.assign(window.nanoseconds.begin(), window.nanoseconds.begin() + window.count);
+
+        for (int i = 0; i < window.count; ++i)
+            maxLoad = juce::jmax(maxLoad, window.loads[(size_t) i]);
+    }
+
+    if (sorted.empty())
+        return statistics;
+
+    std::sort(sorted.begin(), sorted.end());
+
+    auto percentile = [&sorted](double fraction) {
+        return sorted[(size_t) juce::jmin((double) sorted.size() - 1.0, std::floor(fraction * (double) sorted.size()))];
+    };
+
+    statistics.count = (int) sorted.size();
+    statistics.p50 = percentile(0.5);
+    statistics.p99 = percentile(0.99);
+    statistics.max = sorted.back();
+    statistics.maxLoad = maxLoad;
+
+    return statistics;
+}
+
+juce::String StageProfiler::getSummary() const {
+    juce::String summary;
+
+    {
+        const juce::ScopedLock sl(lock);
+        summary << "Rokman profile, " << context;
+    }
+
+    for (int section = 0; section < names.size(); ++section) {
+        auto statistics = getStatistics(section);
+
+        if (statistics.count == 0)
+            continue;
+
+        summary << juce::newLine << "  " << names[section].paddedRight(' ', 12)
+                << "p50 " << juce::String(statistics.p50 / 1000.0, 2) << " us, "
+                << "p99 " << juce::String(statistics.p99 / 1000.0, 2) << " us, "
+                << "max " << juce::String(statistics.max / 1000.0, 2) << " us ("
+                << juce::String(statistics.maxLoad * 100.0, 1) << "% of the block)";
+    }
+
+    auto dropped = numDropped.load(std::memory_order_relaxed);
+
+    if (dropped > 0)
+        summary << juce::newLine << "  " << dropped << " measurements dropped";
+
+    return summary;
+}
+
+void StageProfiler::run() {
+    while (! threadShouldExit()) {
+        wait(100);
+        drain();
+
+        // Every 10 s, once there is something to report
+        auto now = juce::Time::getMillisecondCounterHiRes();
+
+        if (now - lastSummaryTime < 10000.0)
+            continue;
+
+        lastSummaryTime = now;
+
+        for (int section = 0; section < names.size(); ++section) {
+            if (getStatistics(section).count > 0) {
+                juce::Logger::writeToLog(getSummary());
+                break;
+            }
+        }
+    }
+
+    drain();
+}
+
+void StageProfiler::drain() {
+    const auto scope = fifo.read(fifo.getNumReady());
+    const juce::ScopedLock sl(lock);
+
+    auto nanosecondsPerTick = 1.0e9 / (double) juce::Time::getHighResolutionTicksPerSecond();
+    auto time = juce::String(juce::Time::getMillisecondCounterHiRes(), 1);
+
+    scope.forEach([&](int index) {
+        auto& measurement = measurements[(size_t) index];
+
+        if (! juce::isPositiveAndBelow(measurement.section, (int) windows.size()))
+            return;
+
+        auto nanoseconds = (double) measurement.ticks * nanosecondsPerTick;
+        auto budget = (double) measurement.numSamples * 1.0e9 / sampleRate;
+
+        auto& window = windows[(size_t) measurement.section];
+        window.nanoseconds[(size_t) window.next] = nanoseconds;
+        window.loads[(size_t) window.next] = budget > 0.0 ? nanoseconds / budget : 0.0;
+        window.next = (window.next + 1) % windowSize;
+        window.count = juce::jmin(window.count + 1, windowSize);
+
+        if (csv != nullptr)
+            *csv << time << ",\"" << context << "\"," << names[measurement.section] << ","
+                 << measurement.numSamples << "," << juce::String(nanoseconds, 0) << "\n";
+    });
+
+    if (csv != nullptr)
+        csv->flush();
+}
@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    StageProfiler.h
+
+    Optional timing of the audio path, one measurement per stage per block.
+    The audio thread only pushes into a wait-free FIFO; a background thread
+    drains it into rolling p50/p99/max per section, logs a summary every few
+    seconds and can append every measurement to a CSV file.
+
+    Compiled in only when the build defines ROKMAN_PROFILING=1 (Projucer:
+    Preprocessor Definitions). Otherwise ROKMAN_PROFILE_SCOPE expands to
+    nothing and the audio path has no timing code at all.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef ROKMAN_PROFILING
+ #define ROKMAN_PROFILING 0
+#endif
+
+class StageProfiler : private juce::Thread {
+public:
+    // One name per section, the section index is the position in the array
+    explicit StageProfiler(const juce::StringArray& sectionNames);
+    ~StageProfiler() override;
+
+    // Host, sample rate and block size the next measurements belong to, goes
+    // into the summaries and the CSV. Not for the audio thread
+    void setContext(const juce::String& description, double sampleRate);
+
+    // Appends every measurement from now on, an invalid file stops writing
+    void setCSVFile(const juce::File& file);
+
+    // Audio thread, wait-free. A full FIFO drops the measurement
+    void record(int section, int numSamples, juce::int64 ticks) noexcept {
+        const auto scope = fifo.write(1);
+
+        if (scope.blockSize1 > 0)
+            measurements[(size_t) scope.startIndex1] = {section, numSamples, ticks};
+        else
+            numDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    struct Statistics {
+        int count {0};
+
+        // Nanoseconds per block over the rolling window
+        double p50 {0.0}, p99 {0.0}, max {0.0};
+
+        // Worst block as a fraction of its real-time budget
+        double maxLoad {0.0};
+    };
+
+    Statistics getStatistics(int section) const;
+    int getNumSections() const { return names.size(); }
+    juce::String getSummary() const;
+
+    // Times the scope it lives in, does nothing with a null profiler
+    class ScopedTimer {
+    public:
+        ScopedTimer(StageProfiler* newProfiler, int newSection, int newNumSamples) noexcept
+            : profiler(newProfiler), section(newSection), numSamples(newNumSamples),
+              start(newProfiler != nullptr ? juce::Time::getHighResolutionTicks() : 0) {}
+
+        ~ScopedTimer() {
+            if (profiler != nullptr)
+                profiler->record(section, numSamples, juce::Time::getHighResolutionTicks() - start);
+        }
+
+    private:
+        StageProfiler* profiler;
+        int section, numSamples;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedTimer)
+    };
+
+private:
+    struct Measurement {
+        int section;
+        int numSamples;
+        juce::int64 ticks;
+    };
+
+    // Blocks kept per section for the percentiles
+    static constexpr int windowSize = 4096;
+
+    struct Window {
+        std::vector<double> nanoseconds, loads;
+        int next {0}, count {0};
+    };
+
+    const juce::StringArray names;
+
+    juce::AbstractFifo fifo {8192};
+    std::vector<Measurement> measurements;
+    std::atomic<int> numDropped {0};
+
+    // Everything below belongs to the background thread, the lock covers
+    // what the other threads read or set
+    juce::CriticalSection lock;
+    std::vector<Window> windows;
+    juce::String context;
+    double sampleRate {44100.0};
+    std::unique_ptr<juce::FileOutputStream> csv;
+
+    double lastSummaryTime {0.0};
+
+    void run() override;
+    void drain();
+
+    JUCE_DECLARE_NON_COPYABLE(StageProfiler)
+};
+
+#if ROKMAN_PROFILING
+ #define ROKMAN_PROFILE_SCOPE(profiler, section, numSamples) \
+    StageProfiler::ScopedTimer JUCE_JOIN_MACRO(profileScope, __LINE__)(profiler, section, numSamples)
+#else
+ #define ROKMAN_PROFILE_SCOPE(profiler, section, numSamples)
+#endif